@@ -45,8 +45,8 @@ int float_get_next_index(int len, int start);
  * @param len
  * @return
  */
-double* double_malloc(int len);
-float* float_malloc(int len);
+double* double_malloc(int64_t len);
+float* float_malloc(int64_t len);
 
 /**
  * Check If Pointer Is Aligned
@@ -64,6 +64,14 @@ bool check_float_align(const float* arr);
 int64_t double_next_aligned_pointer(const double* addr);
 int64_t float_next_aligned_pointer(const float* addr);
 
+/**
+ * IEEE Half Precision Conversion, Rounding To Nearest Even
+ * @param h / f
+ * @return
+ */
+float f16_to_float(uint16_t h);
+uint16_t float_to_f16(float f);
+
 /** Generic SIMD Support **/
 
 /**
@@ -72,7 +80,23 @@ int64_t float_next_aligned_pointer(const float* addr);
  * AVX
  * AVX2
  * AVX512
- * FMA (PLANNED)
+ * AVX512VL: define AVX512_256 along with AVX512 to keep mask registers,
+ *      rcp14/rsqrt14 and compress on 256-bit vectors. 512-bit instructions
+ *      drop the core into a lower frequency license on several Intel parts,
+ *      which also slows the surrounding scalar code; short bursty kernels often
+ *      run faster at 256 bits while long bandwidth bound loops keep full width.
+ *      The width may differ per translation unit: define AVX512_256 at the top
+ *      of a kernel source to narrow just that kernel, and build generic_simd.c
+ *      at full width. Compare both with the per kernel cycles and license
+ *      counters of simd_instrument.h (SIMD_BACKEND "avx512" vs "avx512vl").
+ *      Pass -mprefer-vector-width=256 too, or the compiler's own vectorized
+ *      loops in that translation unit still use 512-bit registers.
+ * Byte (_u8) scanning ops need AVX512BW under AVX512 and AVX512_256.
+ * Half precision (_f16) loads and stores use F16C under AVX when compiled with
+ *      it (-mf16c); otherwise loads use integer bit manipulation (in 128-bit
+ *      halves without AVX2) and stores convert lane by lane.
+ * FMA: _float_fmadd_vec/_double_fmadd_vec fuse when compiled with FMA support
+ *      (always under AVX512) and SIMD_FMA is defined; otherwise they round twice.
  */
 
 /**
@@ -80,7 +104,29 @@ int64_t float_next_aligned_pointer(const float* addr);
  * -ffast-math: ENABLE USE OF RECIPROCAL INSTRUCTIONS
  *      This can be considerably faster, but introduces a lot of error. See
  *      https://github.com/tanakamura/instruction-bench for CPI comparisons.
+ *      _float_div_exact_vec always divides, for kernels that promise accuracy.
+ * SIMD_DETERMINISTIC: BIT IDENTICAL RESULTS ON EVERY BACKEND
+ *      Reductions accumulate into SIMD_CANON_LANES virtual lanes (element i
+ *      into lane i % SIMD_CANON_LANES, as 16 / FLOAT_VEC_SIZE vectors) that
+ *      are combined by a fixed pairwise tree, whatever the vector width and
+ *      tuning profile. Multiply and add are never fused, and contraction
+ *      and -ffast-math reassociation are turned off for every translation
+ *      unit including this header, reciprocal estimates too. Results depend
+ *      only on the inputs, not on the host or on which thread runs a call.
+ *      The price is measured by simd_deterministic_cost() (simd_tune.h).
  */
+#define SIMD_CANON_LANES 16
+#define FLOAT_CANON_VECS (SIMD_CANON_LANES / FLOAT_VEC_SIZE)
+#define DOUBLE_CANON_VECS (SIMD_CANON_LANES / DOUBLE_VEC_SIZE)
+
+#ifdef SIMD_DETERMINISTIC
+    #if defined(__clang__)
+        #pragma float_control(precise, on)
+        #pragma STDC FP_CONTRACT OFF
+    #elif defined(__GNUC__)
+        #pragma GCC optimize ("no-fast-math", "fp-contract=off")
+    #endif
+#endif
 
 #ifdef AVX
 /** AVX Support **/
@@ -89,14 +135,25 @@ int64_t float_next_aligned_pointer(const float* addr);
     #define __float_vector __m256
     #define __double_vector __m256d
     #define __int_vector __m256i
+    #define __int32_vector __m256i
+    #define __u8_vector __m256i
+    #define __u8_mask __m256i
     #define FLOAT_VEC_SIZE 8
     #define DOUBLE_VEC_SIZE 4
+    #define U8_VEC_SIZE 32
+    #ifdef AVX2
+        #define SIMD_BACKEND "avx2"
+    #else
+        #define SIMD_BACKEND "avx"
+    #endif
     #define simd_malloc(size) (alligned_malloc(256, size))
 
     extern const float fltmax[8];
     extern const float nfltmax[8];
     extern const double dblmax[4];
     extern const double ndblmax[4];
+    extern const uint32_t float_compress_lut[256];
+    extern const uint32_t double_compress_lut[16];
 
     inline FORCE_INLINE void _float_storeu(float* addr, const __float_vector A) {
         _mm256_storeu_ps(addr, A);
@@ -184,7 +241,27 @@ int64_t float_next_aligned_pointer(const float* addr);
         return _mm256_mul_pd(A, B);
     }
 
-#ifdef __FAST_MATH__
+#if defined(__FMA__) && !defined(SIMD_DETERMINISTIC)
+    #define SIMD_FMA
+
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm256_fmadd_ps(A, B, C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm256_fmadd_pd(A, B, C);
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm256_add_ps(_mm256_mul_ps(A, B), C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm256_add_pd(_mm256_mul_pd(A, B), C);
+    }
+#endif
+
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
     inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
         return _mm256_mul_ps(A, _mm256_rcp_ps(B));
     }
@@ -194,6 +271,10 @@ int64_t float_next_aligned_pointer(const float* addr);
     }
 #endif
 
+    inline FORCE_INLINE __float_vector _float_div_exact_vec(__float_vector A, __float_vector B) {
+        return _mm256_div_ps(A, B);
+    }
+
     inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
         return _mm256_div_pd(A, B);
     }
@@ -286,7 +367,7 @@ int64_t float_next_aligned_pointer(const float* addr);
         return _mm256_div_pd(_mm256_set1_pd(1.), _mm256_sqrt_pd(A));
     }
 
-#ifdef __FAST_MATH__
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
     inline FORCE_INLINE __float_vector _float_rsqrt_vec(const __float_vector A) {
         return _mm256_rsqrt_ps(A);
     }
@@ -316,14 +397,284 @@ int64_t float_next_aligned_pointer(const float* addr);
         return _mm256_sqrt_pd(A);
     }
 
+    inline FORCE_INLINE __int_vector _float_lt_vec(const __float_vector A, const __float_vector B) {
+        return _mm256_castps_si256(_mm256_cmp_ps(A, B, _CMP_LT_OQ));
+    }
+
+    inline FORCE_INLINE __int_vector _double_lt_vec(const __double_vector A, const __double_vector B) {
+        return _mm256_castpd_si256(_mm256_cmp_pd(A, B, _CMP_LT_OQ));
+    }
+
+    inline FORCE_INLINE __int_vector _float_le_vec(const __float_vector A, const __float_vector B) {
+        return _mm256_castps_si256(_mm256_cmp_ps(A, B, _CMP_LE_OQ));
+    }
+
+    inline FORCE_INLINE __int_vector _double_le_vec(const __double_vector A, const __double_vector B) {
+        return _mm256_castpd_si256(_mm256_cmp_pd(A, B, _CMP_LE_OQ));
+    }
+
+    inline FORCE_INLINE int _float_compress_storeu(float* addr, const __int_vector mask, const __float_vector A) {
+        int bits = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+        int count = __builtin_popcount(bits);
+    #ifdef AVX2
+        __m256i perm = _mm256_srlv_epi32(_mm256_set1_epi32(float_compress_lut[bits]), _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28));
+        __m256i keep = _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        _mm256_maskstore_ps(addr, keep, _mm256_permutevar8x32_ps(A, perm));
+    #else
+        float lanes[8];
+        _mm256_storeu_ps(lanes, A);
+        for (int i = 0, j = 0; i < FLOAT_VEC_SIZE; i++) {
+            if ((bits >> i) & 1) {
+                addr[j++] = lanes[i];
+            }
+        }
+    #endif
+        return count;
+    }
+
+    inline FORCE_INLINE int _double_compress_storeu(double* addr, const __int_vector mask, const __double_vector A) {
+        int bits = _mm256_movemask_pd(_mm256_castsi256_pd(mask));
+        int count = __builtin_popcount(bits);
+    #ifdef AVX2
+        __m256i perm = _mm256_srlv_epi32(_mm256_set1_epi32(double_compress_lut[bits]), _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28));
+        __m256i keep = _mm256_cmpgt_epi64(_mm256_set1_epi64x(count), _mm256_setr_epi64x(0, 1, 2, 3));
+        _mm256_maskstore_pd(addr, keep, _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(A), perm)));
+    #else
+        double lanes[4];
+        _mm256_storeu_pd(lanes, A);
+        for (int i = 0, j = 0; i < DOUBLE_VEC_SIZE; i++) {
+            if ((bits >> i) & 1) {
+                addr[j++] = lanes[i];
+            }
+        }
+    #endif
+        return count;
+    }
+
+    inline FORCE_INLINE __float_vector _float_reverse_vec(const __float_vector A) {
+        return _mm256_permute_ps(_mm256_permute2f128_ps(A, A, 1), _MM_SHUFFLE(0, 1, 2, 3));
+    }
+
+    inline FORCE_INLINE __double_vector _double_reverse_vec(const __double_vector A) {
+        return _mm256_permute_pd(_mm256_permute2f128_pd(A, A, 1), 0x5);
+    }
+
+    inline FORCE_INLINE __float_vector _float_bitonic_merge_vec(__float_vector A) {
+        __float_vector P = _mm256_permute2f128_ps(A, A, 1);
+        A = _mm256_blend_ps(_mm256_min_ps(A, P), _mm256_max_ps(A, P), 0xF0);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm256_blend_ps(_mm256_min_ps(A, P), _mm256_max_ps(A, P), 0xCC);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm256_blend_ps(_mm256_min_ps(A, P), _mm256_max_ps(A, P), 0xAA);
+    }
+
+    inline FORCE_INLINE __double_vector _double_bitonic_merge_vec(__double_vector A) {
+        __double_vector P = _mm256_permute2f128_pd(A, A, 1);
+        A = _mm256_blend_pd(_mm256_min_pd(A, P), _mm256_max_pd(A, P), 0xC);
+        P = _mm256_permute_pd(A, 0x5);
+        return _mm256_blend_pd(_mm256_min_pd(A, P), _mm256_max_pd(A, P), 0xA);
+    }
+
+    inline FORCE_INLINE __float_vector _float_sort_vec(__float_vector A) {
+        __float_vector P = _mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm256_blend_ps(_mm256_min_ps(A, P), _mm256_max_ps(A, P), 0x66);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm256_blend_ps(_mm256_min_ps(A, P), _mm256_max_ps(A, P), 0x3C);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm256_blend_ps(_mm256_min_ps(A, P), _mm256_max_ps(A, P), 0x5A);
+        return _float_bitonic_merge_vec(A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_sort_vec(__double_vector A) {
+        __double_vector P = _mm256_permute_pd(A, 0x5);
+        A = _mm256_blend_pd(_mm256_min_pd(A, P), _mm256_max_pd(A, P), 0x6);
+        return _double_bitonic_merge_vec(A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_blend_vec(const __float_vector A, const __float_vector B, const __int_vector mask) {
+        return _mm256_blendv_ps(A, B, _mm256_castsi256_ps(mask));
+    }
+
+    inline FORCE_INLINE __double_vector _double_blend_vec(const __double_vector A, const __double_vector B, const __int_vector mask) {
+        return _mm256_blendv_pd(A, B, _mm256_castsi256_pd(mask));
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu(const int32_t* addr) {
+        return _mm256_loadu_si256((const __m256i*) addr);
+    }
+
+    inline FORCE_INLINE void _int32_storeu(int32_t* addr, const __int32_vector A) {
+        _mm256_storeu_si256((__m256i*) addr, A);
+    }
+
+    inline FORCE_INLINE __int32_vector _float_to_int32_vec(const __float_vector A) {
+        return _mm256_cvtps_epi32(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _float_trunc_int32_vec(const __float_vector A) {
+        return _mm256_cvttps_epi32(A);
+    }
+
+    inline FORCE_INLINE __float_vector _int32_to_float_vec(const __int32_vector A) {
+        return _mm256_cvtepi32_ps(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_u8(const uint8_t* addr) {
+    #ifdef AVX2
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) addr));
+    #else
+        __m128i b = _mm_loadl_epi64((const __m128i*) addr);
+        return _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_cvtepu8_epi32(b)), _mm_cvtepu8_epi32(_mm_srli_si128(b, 4)), 1);
+    #endif
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_i8(const int8_t* addr) {
+    #ifdef AVX2
+        return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*) addr));
+    #else
+        __m128i b = _mm_loadl_epi64((const __m128i*) addr);
+        return _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_cvtepi8_epi32(b)), _mm_cvtepi8_epi32(_mm_srli_si128(b, 4)), 1);
+    #endif
+    }
+
+    inline FORCE_INLINE void _int32_storeu_u8(uint8_t* addr, const __int32_vector A) {
+        __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(A), _mm256_extractf128_si256(A, 1));
+        _mm_storel_epi64((__m128i*) addr, _mm_packus_epi16(w, w));
+    }
+
+    inline FORCE_INLINE void _int32_storeu_i8(int8_t* addr, const __int32_vector A) {
+        __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(A), _mm256_extractf128_si256(A, 1));
+        _mm_storel_epi64((__m128i*) addr, _mm_packs_epi16(w, w));
+    }
+
+#ifdef __F16C__
+    inline FORCE_INLINE __float_vector _float_loadu_f16(const uint16_t* addr) {
+        return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) addr));
+    }
+
+    inline FORCE_INLINE void _float_storeu_f16(uint16_t* addr, const __float_vector A) {
+        _mm_storeu_si128((__m128i*) addr, _mm256_cvtps_ph(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_loadu_f16(const uint16_t* addr) {
+    #ifdef AVX2
+        __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) addr));
+        __m256i em = _mm256_and_si256(h, _mm256_set1_epi32(0x7fff));
+        __m256i sign = _mm256_slli_epi32(_mm256_xor_si256(h, em), 16);
+        __m256i special = _mm256_and_si256(_mm256_cmpgt_epi32(em, _mm256_set1_epi32(0x7bff)), _mm256_set1_epi32(0x38000000));
+        __m256i norm = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(em, 13), _mm256_set1_epi32(0x38000000)), special);
+        __m256i is_sub = _mm256_cmpgt_epi32(_mm256_set1_epi32(0x400), em);
+    #else
+        __m128i raw = _mm_loadu_si128((const __m128i*) addr);
+        __m128i h[2] = {_mm_cvtepu16_epi32(raw), _mm_unpackhi_epi16(raw, _mm_setzero_si128())};
+        __m128i e[2], s[2], n[2], u[2];
+        for (int k = 0; k < 2; k++) {
+            e[k] = _mm_and_si128(h[k], _mm_set1_epi32(0x7fff));
+            s[k] = _mm_slli_epi32(_mm_xor_si128(h[k], e[k]), 16);
+            __m128i special = _mm_and_si128(_mm_cmpgt_epi32(e[k], _mm_set1_epi32(0x7bff)), _mm_set1_epi32(0x38000000));
+            n[k] = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(e[k], 13), _mm_set1_epi32(0x38000000)), special);
+            u[k] = _mm_cmplt_epi32(e[k], _mm_set1_epi32(0x400));
+        }
+        __m256i em = _mm256_insertf128_si256(_mm256_castsi128_si256(e[0]), e[1], 1);
+        __m256i sign = _mm256_insertf128_si256(_mm256_castsi128_si256(s[0]), s[1], 1);
+        __m256i norm = _mm256_insertf128_si256(_mm256_castsi128_si256(n[0]), n[1], 1);
+        __m256i is_sub = _mm256_insertf128_si256(_mm256_castsi128_si256(u[0]), u[1], 1);
+    #endif
+        __m256 sub = _mm256_mul_ps(_mm256_cvtepi32_ps(em), _mm256_set1_ps(0x1p-24f));
+        __m256 f = _mm256_blendv_ps(_mm256_castsi256_ps(norm), sub, _mm256_castsi256_ps(is_sub));
+        return _mm256_or_ps(f, _mm256_castsi256_ps(sign));
+    }
+
+    inline FORCE_INLINE void _float_storeu_f16(uint16_t* addr, const __float_vector A) {
+        float lanes[8];
+        _mm256_storeu_ps(lanes, A);
+        for (int i = 0; i < 8; i++) {
+            addr[i] = float_to_f16(lanes[i]);
+        }
+    }
+#endif
+
+    inline FORCE_INLINE __int32_vector _int32_add_vec(const __int32_vector A, const __int32_vector B) {
+    #ifdef AVX2
+        return _mm256_add_epi32(A, B);
+    #else
+        __m128i lo = _mm_add_epi32(_mm256_castsi256_si128(A), _mm256_castsi256_si128(B));
+        __m128i hi = _mm_add_epi32(_mm256_extractf128_si256(A, 1), _mm256_extractf128_si256(B, 1));
+        return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    #endif
+    }
+
+    inline FORCE_INLINE __float_vector _float_gather_vec(const float* base, const __int32_vector idx) {
+    #ifdef AVX2
+        return _mm256_i32gather_ps(base, idx, 4);
+    #else
+        int32_t lanes[8];
+        _mm256_storeu_si256((__m256i*) lanes, idx);
+        return _mm256_setr_ps(base[lanes[0]], base[lanes[1]], base[lanes[2]], base[lanes[3]],
+                              base[lanes[4]], base[lanes[5]], base[lanes[6]], base[lanes[7]]);
+    #endif
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_loadu(const uint8_t* addr) {
+        return _mm256_loadu_si256((const __m256i*) addr);
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_set1_vec(uint8_t a) {
+        return _mm256_set1_epi8((char) a);
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_eq_vec(const __u8_vector A, const __u8_vector B) {
+    #ifdef AVX2
+        return _mm256_cmpeq_epi8(A, B);
+    #else
+        __m128i lo = _mm_cmpeq_epi8(_mm256_castsi256_si128(A), _mm256_castsi256_si128(B));
+        __m128i hi = _mm_cmpeq_epi8(_mm256_extractf128_si256(A, 1), _mm256_extractf128_si256(B, 1));
+        return _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    #endif
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_or_mask(const __u8_mask A, const __u8_mask B) {
+        return _mm256_castps_si256(_mm256_or_ps(_mm256_castsi256_ps(A), _mm256_castsi256_ps(B)));
+    }
+
+    inline FORCE_INLINE uint64_t _u8_movemask(const __u8_mask A) {
+    #ifdef AVX2
+        return (uint32_t) _mm256_movemask_epi8(A);
+    #else
+        return (uint32_t) _mm_movemask_epi8(_mm256_castsi256_si128(A)) | (uint64_t) _mm_movemask_epi8(_mm256_extractf128_si256(A, 1)) << 16;
+    #endif
+    }
+
+    inline FORCE_INLINE __float_vector _float_pow2_int32_vec(const __int32_vector n) {
+    #ifdef AVX2
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+    #else
+        __m128i bias = _mm_set1_epi32(127);
+        __m128i lo = _mm_slli_epi32(_mm_add_epi32(_mm256_castsi256_si128(n), bias), 23);
+        __m128i hi = _mm_slli_epi32(_mm_add_epi32(_mm256_extractf128_si256(n, 1), bias), 23);
+        return _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+    #endif
+    }
+
+    inline FORCE_INLINE __float_vector _float_hsum_lanes_vec(const __float_vector* A) {
+        __m256 lo = _mm256_hadd_ps(_mm256_hadd_ps(A[0], A[1]), _mm256_hadd_ps(A[2], A[3]));
+        __m256 hi = _mm256_hadd_ps(_mm256_hadd_ps(A[4], A[5]), _mm256_hadd_ps(A[6], A[7]));
+        return _mm256_add_ps(_mm256_permute2f128_ps(lo, hi, 0x20), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+
 #elif defined(SSE2)
 /** SSE Support **/
     #include <immintrin.h>
     #define __float_vector __m128
     #define __double_vector __m128d
     #define __int_vector __m128i
+    #define __int32_vector __m128i
+    #define __u8_vector __m128i
+    #define __u8_mask __m128i
     #define FLOAT_VEC_SIZE 4
     #define DOUBLE_VEC_SIZE 2
+    #define U8_VEC_SIZE 16
+    #define SIMD_BACKEND "sse2"
     #define simd_malloc(size) (alligned_malloc(128, size))
 
     inline FORCE_INLINE void _float_storeu(float* addr, const __float_vector A) {
@@ -373,28 +724,36 @@ int64_t float_next_aligned_pointer(const float* addr);
     }
 
     inline FORCE_INLINE __float_vector _float_maskload(const float* addr, const __int_vector mask) {
-        return _mm_set_ps(mask[0] != 0 ? addr[0] : 0,
-                          mask[32] != 0 ? addr[1] : 0,
-                          mask[64] != 0 ? addr[2] : 0,
-                          mask[96] != 0 ? addr[3] : 0);
+        int32_t on[4];
+        _mm_storeu_si128((__m128i*) on, mask);
+        return _mm_setr_ps(on[0] != 0 ? addr[0] : 0,
+                           on[1] != 0 ? addr[1] : 0,
+                           on[2] != 0 ? addr[2] : 0,
+                           on[3] != 0 ? addr[3] : 0);
     }
 
     inline FORCE_INLINE __double_vector _double_maskload(const double* addr, const __int_vector mask) {
-        return _mm_set_pd(mask[0] != 0 ? addr[0] : 0,
-                          mask[32] != 0 ? addr[1] : 0);
+        int64_t on[2];
+        _mm_storeu_si128((__m128i*) on, mask);
+        return _mm_setr_pd(on[0] != 0 ? addr[0] : 0,
+                           on[1] != 0 ? addr[1] : 0);
     }
 
     inline FORCE_INLINE void _float_maskstore(float* addr, const __int_vector mask, const __float_vector A) {
+        int32_t on[4];
+        _mm_storeu_si128((__m128i*) on, mask);
         for (int i = 0; i < FLOAT_VEC_SIZE; i++) {
-            if (mask[i*32] != 0) {
+            if (on[i] != 0) {
                 addr[i] = A[i];
             }
         }
     }
 
     inline FORCE_INLINE void _double_maskstore(double* addr, const __int_vector mask, const __double_vector A) {
+        int64_t on[2];
+        _mm_storeu_si128((__m128i*) on, mask);
         for (int i = 0; i < DOUBLE_VEC_SIZE; i++) {
-            if (mask[i*32] != 0) {
+            if (on[i] != 0) {
                 addr[i] = A[i];
             }
         }
@@ -424,7 +783,27 @@ int64_t float_next_aligned_pointer(const float* addr);
         return _mm_mul_pd(A, B);
     }
 
-#ifdef __FAST_MATH__
+#if defined(__FMA__) && !defined(SIMD_DETERMINISTIC)
+    #define SIMD_FMA
+
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm_fmadd_ps(A, B, C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm_fmadd_pd(A, B, C);
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm_add_ps(_mm_mul_ps(A, B), C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm_add_pd(_mm_mul_pd(A, B), C);
+    }
+#endif
+
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
     inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
         return _mm_mul_ps(A, _mm_rcp_ps(B));
     }
@@ -434,6 +813,10 @@ int64_t float_next_aligned_pointer(const float* addr);
     }
 #endif
 
+    inline FORCE_INLINE __float_vector _float_div_exact_vec(__float_vector A, __float_vector B) {
+        return _mm_div_ps(A, B);
+    }
+
     inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
         return _mm_div_pd(A, B);
     }
@@ -522,7 +905,7 @@ int64_t float_next_aligned_pointer(const float* addr);
         return A[i];
     }
 
-#ifdef __FAST_MATH__
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
     inline FORCE_INLINE __float_vector _float_recp_vec(const __float_vector A) {
         return _mm_rcp_ps(A);
     }
@@ -540,11 +923,11 @@ int64_t float_next_aligned_pointer(const float* addr);
     }
 
     inline FORCE_INLINE __float_vector _float_rsqrt_vec(const __float_vector A) {
-        _mm_div_ps(_mm_set1_ps(1.), _mm_sqrt_ps(A));
+        return _mm_div_ps(_mm_set1_ps(1.), _mm_sqrt_ps(A));
     }
 
     inline FORCE_INLINE __float_vector _float_sqrt_vec(const __float_vector A) {
-        return _mm_rcp_ps(_mm_rsqrt_ps(A));
+        return _mm_sqrt_ps(A);
     }
 #endif
 
@@ -560,182 +943,823 @@ int64_t float_next_aligned_pointer(const float* addr);
         return _mm_sqrt_pd(A);
     }
 
-#elif defined(AVX512)
-/** AVX512 Support **/
-    #include <immintrin.h>
-    #include <avx512fintrin.h>
+    inline FORCE_INLINE __int_vector _float_lt_vec(const __float_vector A, const __float_vector B) {
+        return _mm_castps_si128(_mm_cmplt_ps(A, B));
+    }
 
-    #define __float_vector __m512
-    #define __double_vector __m512d
-    #define __int_vector __mmask16
-    #define FLOAT_VEC_SIZE 16
-    #define DOUBLE_VEC_SIZE 8
-    #define simd_malloc(size) (alligned_malloc(512, size))
+    inline FORCE_INLINE __int_vector _double_lt_vec(const __double_vector A, const __double_vector B) {
+        return _mm_castpd_si128(_mm_cmplt_pd(A, B));
+    }
 
-    inline FORCE_INLINE void _float_storeu(float* addr, const __float_vector A) {
-        _mm512_storeu_ps(addr, A);
+    inline FORCE_INLINE __int_vector _float_le_vec(const __float_vector A, const __float_vector B) {
+        return _mm_castps_si128(_mm_cmple_ps(A, B));
     }
 
-    inline FORCE_INLINE void _double_storeu(double* addr, const __double_vector A) {
-        _mm512_storeu_pd(addr, A);
+    inline FORCE_INLINE __int_vector _double_le_vec(const __double_vector A, const __double_vector B) {
+        return _mm_castpd_si128(_mm_cmple_pd(A, B));
     }
 
-    inline FORCE_INLINE void _float_store(float* addr, const __float_vector A) {
-        _mm512_stream_ps(addr, A);
+    inline FORCE_INLINE int _float_compress_storeu(float* addr, const __int_vector mask, const __float_vector A) {
+        int bits = _mm_movemask_ps(_mm_castsi128_ps(mask));
+        int j = 0;
+        for (int i = 0; i < FLOAT_VEC_SIZE; i++) {
+            if ((bits >> i) & 1) {
+                addr[j++] = A[i];
+            }
+        }
+        return j;
     }
 
-    inline FORCE_INLINE void _double_store(double* addr, const __double_vector A) {
-        _mm512_stream_pd(addr, A);
+    inline FORCE_INLINE int _double_compress_storeu(double* addr, const __int_vector mask, const __double_vector A) {
+        int bits = _mm_movemask_pd(_mm_castsi128_pd(mask));
+        int j = 0;
+        for (int i = 0; i < DOUBLE_VEC_SIZE; i++) {
+            if ((bits >> i) & 1) {
+                addr[j++] = A[i];
+            }
+        }
+        return j;
     }
 
-    inline FORCE_INLINE __float_vector _float_loadu(const float* addr) {
-        return _mm512_loadu_ps(addr);
+    inline FORCE_INLINE __float_vector _float_reverse_vec(const __float_vector A) {
+        return _mm_shuffle_ps(A, A, _MM_SHUFFLE(0, 1, 2, 3));
     }
 
-    inline FORCE_INLINE __double_vector _double_loadu(const double* addr) {
-        return _mm512_loadu_pd(addr);
+    inline FORCE_INLINE __double_vector _double_reverse_vec(const __double_vector A) {
+        return _mm_shuffle_pd(A, A, 1);
     }
 
-    inline FORCE_INLINE __int_vector _int_loadu(const void* addr) {
-        return __builtin_ia32_kmovw((__int_vector) addr);
+    inline FORCE_INLINE __float_vector _float_bitonic_merge_vec(__float_vector A) {
+        __float_vector P = _mm_shuffle_ps(A, A, _MM_SHUFFLE(1, 0, 3, 2));
+        __float_vector L = _mm_min_ps(A, P);
+        __float_vector H = _mm_max_ps(A, P);
+        A = _mm_shuffle_ps(L, H, _MM_SHUFFLE(3, 2, 1, 0));
+        P = _mm_shuffle_ps(A, A, _MM_SHUFFLE(2, 3, 0, 1));
+        L = _mm_min_ps(A, P);
+        H = _mm_max_ps(A, P);
+        A = _mm_shuffle_ps(L, H, _MM_SHUFFLE(2, 0, 2, 0));
+        return _mm_shuffle_ps(A, A, _MM_SHUFFLE(3, 1, 2, 0));
     }
 
-    inline FORCE_INLINE __float_vector _float_load(const float* addr) {
-        return _mm512_stream_load_si512(addr);
+    inline FORCE_INLINE __double_vector _double_bitonic_merge_vec(const __double_vector A) {
+        __double_vector P = _mm_shuffle_pd(A, A, 1);
+        return _mm_move_sd(_mm_max_pd(A, P), _mm_min_pd(A, P));
     }
 
-    inline FORCE_INLINE __double_vector _double_load(const double* addr) {
-        return _mm512_stream_load_si512(addr);
+    inline FORCE_INLINE __float_vector _float_sort_vec(__float_vector A) {
+        __float_vector P = _mm_shuffle_ps(A, A, _MM_SHUFFLE(2, 3, 0, 1));
+        __float_vector L = _mm_min_ps(A, P);
+        __float_vector H = _mm_max_ps(A, P);
+        // Ascending pair in lanes 0-1, descending pair in lanes 2-3.
+        A = _mm_shuffle_ps(_mm_unpacklo_ps(L, H), _mm_unpackhi_ps(H, L), _MM_SHUFFLE(3, 2, 1, 0));
+        return _float_bitonic_merge_vec(A);
     }
 
-    inline FORCE_INLINE __float_vector _float_maskload(const float* addr, const __int_vector mask) {
-        return _mm512_mask_loadu_ps(_mm512_setzero_ps(), mask, addr);
+    inline FORCE_INLINE __double_vector _double_sort_vec(const __double_vector A) {
+        return _double_bitonic_merge_vec(A);
     }
 
-    inline FORCE_INLINE __double_vector _double_maskload(const double* addr, const __int_vector mask) {
-        return _mm512_mask_loadu_pd(_mm512_setzero_pd(), (__mmask8) mask, addr);
+    inline FORCE_INLINE __float_vector _float_blend_vec(const __float_vector A, const __float_vector B, const __int_vector mask) {
+        __m128 m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, B), _mm_andnot_ps(m, A));
     }
 
-    inline FORCE_INLINE void _float_maskstore(float* addr, const __int_vector mask, const __float_vector A) {
-        _mm512_mask_storeu_ps(addr, mask, A);
+    inline FORCE_INLINE __double_vector _double_blend_vec(const __double_vector A, const __double_vector B, const __int_vector mask) {
+        __m128d m = _mm_castsi128_pd(mask);
+        return _mm_or_pd(_mm_and_pd(m, B), _mm_andnot_pd(m, A));
     }
 
-    inline FORCE_INLINE void _double_maskstore(double* addr, const __int_vector mask, __double_vector A) {
-        _mm512_mask_storeu_pd(addr, mask, A);
+    inline FORCE_INLINE __int32_vector _int32_loadu(const int32_t* addr) {
+        return _mm_loadu_si128((const __m128i*) addr);
     }
 
-    inline FORCE_INLINE __double_vector _double_loadu2(const double* A, const double* B) {
-        return _mm512_insertf64x4(_mm512_setzero_pd(), _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(A)), _mm_loadu_pd(B), 1), 0);
+    inline FORCE_INLINE void _int32_storeu(int32_t* addr, const __int32_vector A) {
+        _mm_storeu_si128((__m128i*) addr, A);
     }
 
-    inline FORCE_INLINE __double_vector _double_loadu2_from_float(const float* A, const float* B) {
-        return _double_loadu((double[4]) {A[0], A[1], B[0], B[1]});
+    inline FORCE_INLINE __int32_vector _float_to_int32_vec(const __float_vector A) {
+        return _mm_cvtps_epi32(A);
     }
 
-    inline FORCE_INLINE __float_vector _float_add_vec(__float_vector A, __float_vector B) {
-        return _mm512_add_ps(A, B);
+    inline FORCE_INLINE __int32_vector _float_trunc_int32_vec(const __float_vector A) {
+        return _mm_cvttps_epi32(A);
     }
 
-    inline FORCE_INLINE __double_vector _double_add_vec(__double_vector A, __double_vector B) {
-        return _mm512_add_pd(A, B);
+    inline FORCE_INLINE __float_vector _int32_to_float_vec(const __int32_vector A) {
+        return _mm_cvtepi32_ps(A);
     }
 
-    inline FORCE_INLINE __float_vector _float_sub_vec(__float_vector A, __float_vector B) {
-        return _mm512_sub_ps(A, B);
+    inline FORCE_INLINE __int32_vector _int32_loadu_u8(const uint8_t* addr) {
+        int32_t bytes;
+        memcpy(&bytes, addr, sizeof(bytes));
+        __m128i zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
     }
 
-    inline FORCE_INLINE __double_vector _double_sub_vec(__double_vector A, __double_vector B) {
-        return _mm512_sub_pd(A, B);
+    inline FORCE_INLINE __int32_vector _int32_loadu_i8(const int8_t* addr) {
+        int32_t bytes;
+        memcpy(&bytes, addr, sizeof(bytes));
+        __m128i b = _mm_cvtsi32_si128(bytes);
+        b = _mm_unpacklo_epi8(b, b);
+        return _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 24);
     }
 
-    inline FORCE_INLINE __float_vector _float_mul_vec(__float_vector A, __float_vector B) {
-        return _mm512_mul_ps(A, B);
+    inline FORCE_INLINE void _int32_storeu_u8(uint8_t* addr, const __int32_vector A) {
+        __m128i w = _mm_packs_epi32(A, A);
+        int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(w, w));
+        memcpy(addr, &bytes, sizeof(bytes));
     }
 
-    inline FORCE_INLINE __double_vector _double_mul_vec(__double_vector A, __double_vector B) {
-        return _mm512_mul_pd(A, B);
+    inline FORCE_INLINE void _int32_storeu_i8(int8_t* addr, const __int32_vector A) {
+        __m128i w = _mm_packs_epi32(A, A);
+        int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(w, w));
+        memcpy(addr, &bytes, sizeof(bytes));
     }
 
-#ifdef __FAST_MATH__
-    inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
-        return _mm512_mul_ps(A, _mm512_rcp14_ps(B));
+    inline FORCE_INLINE __float_vector _float_loadu_f16(const uint16_t* addr) {
+        __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*) addr), _mm_setzero_si128());
+        __m128i em = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, em), 16);
+        __m128i special = _mm_and_si128(_mm_cmpgt_epi32(em, _mm_set1_epi32(0x7bff)), _mm_set1_epi32(0x38000000));
+        __m128i norm = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(em, 13), _mm_set1_epi32(0x38000000)), special);
+        __m128 sub = _mm_mul_ps(_mm_cvtepi32_ps(em), _mm_set1_ps(0x1p-24f));
+        __m128 is_sub = _mm_castsi128_ps(_mm_cmplt_epi32(em, _mm_set1_epi32(0x400)));
+        __m128 f = _mm_or_ps(_mm_and_ps(is_sub, sub), _mm_andnot_ps(is_sub, _mm_castsi128_ps(norm)));
+        return _mm_or_ps(f, _mm_castsi128_ps(sign));
     }
 
-    inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
-        return _mm512_mul_pd(A, _mm512_rcp14_pd(B));
+    inline FORCE_INLINE void _float_storeu_f16(uint16_t* addr, const __float_vector A) {
+        float lanes[4];
+        _mm_storeu_ps(lanes, A);
+        for (int i = 0; i < 4; i++) {
+            addr[i] = float_to_f16(lanes[i]);
+        }
     }
-#else
-    inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
-        return _mm512_div_ps(A, B);
+
+    inline FORCE_INLINE __int32_vector _int32_add_vec(const __int32_vector A, const __int32_vector B) {
+        return _mm_add_epi32(A, B);
     }
 
-    inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
-        return _mm512_div_pd(A, B);
+    inline FORCE_INLINE __float_vector _float_gather_vec(const float* base, const __int32_vector idx) {
+        int32_t lanes[4];
+        _mm_storeu_si128((__m128i*) lanes, idx);
+        return _mm_setr_ps(base[lanes[0]], base[lanes[1]], base[lanes[2]], base[lanes[3]]);
     }
-#endif
 
-    inline FORCE_INLINE __float_vector _float_set1_vec(float a) {
-        return _mm512_set1_ps(a);
+    inline FORCE_INLINE __u8_vector _u8_loadu(const uint8_t* addr) {
+        return _mm_loadu_si128((const __m128i*) addr);
     }
 
-    inline FORCE_INLINE __double_vector _double_set1_vec(double a) {
-        return _mm512_set1_pd(a);
+    inline FORCE_INLINE __u8_vector _u8_set1_vec(uint8_t a) {
+        return _mm_set1_epi8((char) a);
     }
 
-    inline FORCE_INLINE __float_vector _float_set_vec(float a, float b, float c, float d, float e, float f, float g, float h, float i, float j, float k, float l, float m, float n, float o, float p) {
-        return _mm512_set_ps(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
+    inline FORCE_INLINE __u8_mask _u8_eq_vec(const __u8_vector A, const __u8_vector B) {
+        return _mm_cmpeq_epi8(A, B);
     }
 
-    inline FORCE_INLINE __double_vector _double_set_vec(double a, double b, double c, double d, double e, double f, double g, double h) {
-        return _mm512_set_pd(a, b, c, d, e, f, g, h);
+    inline FORCE_INLINE __u8_mask _u8_or_mask(const __u8_mask A, const __u8_mask B) {
+        return _mm_or_si128(A, B);
     }
 
-    inline FORCE_INLINE __float_vector _float_abs_vec(__float_vector x, __float_vector sign_mask) {
-        return _mm512_andnot_ps(sign_mask, x);
+    inline FORCE_INLINE uint64_t _u8_movemask(const __u8_mask A) {
+        return (uint32_t) _mm_movemask_epi8(A);
     }
 
-    inline FORCE_INLINE __double_vector _double_abs_vec(__double_vector x, __double_vector sign_mask) {
-        return _mm512_andnot_pd(sign_mask, x);
+    inline FORCE_INLINE __float_vector _float_pow2_int32_vec(const __int32_vector n) {
+        return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
     }
 
-    inline FORCE_INLINE __float_vector _float_max_vec(__float_vector A, __float_vector B) {
-        return _mm512_max_ps(A, B);
+    inline FORCE_INLINE __float_vector _float_hsum_lanes_vec(const __float_vector* A) {
+        __m128 r0 = A[0], r1 = A[1], r2 = A[2], r3 = A[3];
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        return _mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3));
     }
 
-    inline FORCE_INLINE __double_vector _double_max_vec(__double_vector A, __double_vector B) {
-        return _mm512_max_pd(A, B);
+#elif defined(AVX512) && defined(AVX512_256)
+/** AVX512VL Support (256-bit) **/
+    #include <immintrin.h>
+
+    #define __float_vector __m256
+    #define __double_vector __m256d
+    #define __int_vector __mmask8
+    #define __int32_vector __m256i
+    #define __u8_vector __m256i
+    #define __u8_mask __mmask32
+    #define FLOAT_VEC_SIZE 8
+    #define DOUBLE_VEC_SIZE 4
+    #define U8_VEC_SIZE 32
+    #define SIMD_BACKEND "avx512vl"
+    #define simd_malloc(size) (alligned_malloc(256, size))
+
+    inline FORCE_INLINE void _float_storeu(float* addr, const __float_vector A) {
+        _mm256_storeu_ps(addr, A);
     }
 
-    inline FORCE_INLINE __float_vector _float_mask_max_vec(__float_vector A, __float_vector B, __int_vector mask) {
-        return _mm512_mask_max_ps(_mm512_set1_ps(-FLT_MAX), mask, A, B);
+    inline FORCE_INLINE void _double_storeu(double* addr, const __double_vector A) {
+        _mm256_storeu_pd(addr, A);
     }
 
-    inline FORCE_INLINE __double_vector _double_mask_max_vec(__double_vector A, __double_vector B, __int_vector mask) {
-        return _mm512_mask_max_ps(_mm512_set1_ps(-DBL_MAX), (__mmask8) mask, A, B);
+    inline FORCE_INLINE void _float_store(float* addr, const __float_vector A) {
+        _mm256_stream_ps(addr, A);
     }
 
-    inline FORCE_INLINE __float_vector _float_min_vec(__float_vector A, __float_vector B) {
-        return _mm512_min_ps(A, B);
+    inline FORCE_INLINE void _double_store(double* addr, const __double_vector A) {
+        _mm256_stream_pd(addr, A);
     }
 
-    inline FORCE_INLINE __double_vector _double_min_vec(__double_vector A, __double_vector B) {
-        return _mm512_min_pd(A, B);
+    inline FORCE_INLINE __float_vector _float_loadu(const float* addr) {
+        return _mm256_loadu_ps(addr);
     }
 
-    inline FORCE_INLINE __float_vector _float_mask_min_vec(__float_vector A, __float_vector B, __int_vector mask) {
-        return _mm512_mask_min_ps(_mm512_set1_ps(FLT_MAX), mask, A, B);
+    inline FORCE_INLINE __double_vector _double_loadu(const double* addr) {
+        return _mm256_loadu_pd(addr);
     }
 
-    inline FORCE_INLINE __double_vector _double_mask_min_vec(__double_vector A, __double_vector B, __int_vector mask) {
-        return _mm512_mask_min_ps(_mm512_set1_ps(DBL_MAX), (__mmask8) mask, A, B);
+    inline FORCE_INLINE __int_vector _int_loadu(const void* addr) {
+        return *(const __int_vector*) addr;
     }
 
-    inline FORCE_INLINE __float_vector _float_setzero_vec() {
-        return _mm512_setzero_ps();
+    inline FORCE_INLINE __float_vector _float_load(const float* addr) {
+        return _mm256_castsi256_ps(_mm256_stream_load_si256((const __m256i *) addr));
     }
 
-    inline FORCE_INLINE __double_vector _double_setzero_vec() {
-        return _mm512_setzero_pd();
+    inline FORCE_INLINE __double_vector _double_load(const double* addr) {
+        return _mm256_castsi256_pd(_mm256_stream_load_si256((const __m256i *) addr));
+    }
+
+    inline FORCE_INLINE __float_vector _float_maskload(const float* addr, const __int_vector mask) {
+        return _mm256_mask_loadu_ps(_mm256_setzero_ps(), mask, addr);
+    }
+
+    inline FORCE_INLINE __double_vector _double_maskload(const double* addr, const __int_vector mask) {
+        return _mm256_mask_loadu_pd(_mm256_setzero_pd(), mask, addr);
+    }
+
+    inline FORCE_INLINE void _float_maskstore(float* addr, const __int_vector mask, const __float_vector A) {
+        _mm256_mask_storeu_ps(addr, mask, A);
+    }
+
+    inline FORCE_INLINE void _double_maskstore(double* addr, const __int_vector mask, __double_vector A) {
+        _mm256_mask_storeu_pd(addr, mask, A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_loadu2(const double* A, const double* B) {
+        return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(A)), _mm_loadu_pd(B), 1);
+    }
+
+    inline FORCE_INLINE __double_vector _double_loadu2_from_float(const float* A, const float* B) {
+        return _double_loadu((double[4]) {A[0], A[1], B[0], B[1]});
+    }
+
+    inline FORCE_INLINE __float_vector _float_add_vec(__float_vector A, __float_vector B) {
+        return _mm256_add_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_add_vec(__double_vector A, __double_vector B) {
+        return _mm256_add_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_sub_vec(__float_vector A, __float_vector B) {
+        return _mm256_sub_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_sub_vec(__double_vector A, __double_vector B) {
+        return _mm256_sub_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_mul_vec(__float_vector A, __float_vector B) {
+        return _mm256_mul_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_mul_vec(__double_vector A, __double_vector B) {
+        return _mm256_mul_pd(A, B);
+    }
+
+#ifndef SIMD_DETERMINISTIC
+    // Full mask EVEX forms need only AVX512VL, not a separate -mfma.
+    #define SIMD_FMA
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm256_mask3_fmadd_ps(A, B, C, 0xFF);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm256_mask3_fmadd_pd(A, B, C, 0xF);
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm256_add_ps(_mm256_mul_ps(A, B), C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm256_add_pd(_mm256_mul_pd(A, B), C);
+    }
+#endif
+
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
+    inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
+        return _mm256_mul_ps(A, _mm256_rcp14_ps(B));
+    }
+
+    inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
+        return _mm256_mul_pd(A, _mm256_rcp14_pd(B));
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
+        return _mm256_div_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
+        return _mm256_div_pd(A, B);
+    }
+#endif
+
+    inline FORCE_INLINE __float_vector _float_div_exact_vec(__float_vector A, __float_vector B) {
+        return _mm256_div_ps(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_set1_vec(float a) {
+        return _mm256_set1_ps(a);
+    }
+
+    inline FORCE_INLINE __double_vector _double_set1_vec(double a) {
+        return _mm256_set1_pd(a);
+    }
+
+    inline FORCE_INLINE __float_vector _float_set_vec(float a, float b, float c, float d, float e, float f, float g, float h) {
+        return _mm256_set_ps(a, b, c, d, e, f, g, h);
+    }
+
+    inline FORCE_INLINE __double_vector _double_set_vec(double a, double b, double c, double d) {
+        return _mm256_set_pd(a, b, c, d);
+    }
+
+    inline FORCE_INLINE __float_vector _float_abs_vec(__float_vector x, __float_vector sign_mask) {
+        return _mm256_andnot_ps(sign_mask, x);
+    }
+
+    inline FORCE_INLINE __double_vector _double_abs_vec(__double_vector x, __double_vector sign_mask) {
+        return _mm256_andnot_pd(sign_mask, x);
+    }
+
+    inline FORCE_INLINE __float_vector _float_max_vec(__float_vector A, __float_vector B) {
+        return _mm256_max_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_max_vec(__double_vector A, __double_vector B) {
+        return _mm256_max_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_mask_max_vec(__float_vector A, __float_vector B, __int_vector mask) {
+        return _mm256_mask_max_ps(_mm256_set1_ps(-FLT_MAX), mask, A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_mask_max_vec(__double_vector A, __double_vector B, __int_vector mask) {
+        return _mm256_mask_max_pd(_mm256_set1_pd(-DBL_MAX), mask, A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_min_vec(__float_vector A, __float_vector B) {
+        return _mm256_min_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_min_vec(__double_vector A, __double_vector B) {
+        return _mm256_min_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_mask_min_vec(__float_vector A, __float_vector B, __int_vector mask) {
+        return _mm256_mask_min_ps(_mm256_set1_ps(FLT_MAX), mask, A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_mask_min_vec(__double_vector A, __double_vector B, __int_vector mask) {
+        return _mm256_mask_min_pd(_mm256_set1_pd(DBL_MAX), mask, A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_setzero_vec() {
+        return _mm256_setzero_ps();
+    }
+
+    inline FORCE_INLINE __double_vector _double_setzero_vec() {
+        return _mm256_setzero_pd();
+    }
+
+    inline FORCE_INLINE float _float_index_vec(const __float_vector A, const int i) {
+        return A[i];
+    }
+
+    inline FORCE_INLINE double _double_index_vec(const __double_vector A, const int i) {
+        return A[i];
+    }
+
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
+    inline FORCE_INLINE __float_vector _float_recp_vec(const __float_vector A) {
+        return _mm256_rcp14_ps(A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_recp_vec(const __double_vector A) {
+        return _mm256_rcp14_pd(A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_rsqrt_vec(const __float_vector A) {
+        return _mm256_rsqrt14_ps(A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_rsqrt_vec(const __double_vector A) {
+        return _mm256_rsqrt14_pd(A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_sqrt_vec(const __float_vector A) {
+        return _mm256_rcp14_ps(_mm256_rsqrt14_ps(A));
+    }
+
+    inline FORCE_INLINE __double_vector _double_sqrt_vec(const __double_vector A) {
+        return _mm256_rcp14_pd(_mm256_rsqrt14_pd(A));
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_recp_vec(const __float_vector A) {
+        return _mm256_div_ps(_mm256_set1_ps(1.f), A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_recp_vec(const __double_vector A) {
+        return _mm256_div_pd(_mm256_set1_pd(1.), A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_rsqrt_vec(const __float_vector A) {
+        return _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_sqrt_ps(A));
+    }
+
+    inline FORCE_INLINE __double_vector _double_rsqrt_vec(const __double_vector A) {
+        return _mm256_div_pd(_mm256_set1_pd(1.), _mm256_sqrt_pd(A));
+    }
+
+    inline FORCE_INLINE __float_vector _float_sqrt_vec(const __float_vector A) {
+        return _mm256_sqrt_ps(A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_sqrt_vec(const __double_vector A) {
+        return _mm256_sqrt_pd(A);
+    }
+#endif
+
+    inline FORCE_INLINE __int_vector _float_lt_vec(const __float_vector A, const __float_vector B) {
+        return _mm256_cmp_ps_mask(A, B, _CMP_LT_OQ);
+    }
+
+    inline FORCE_INLINE __int_vector _double_lt_vec(const __double_vector A, const __double_vector B) {
+        return _mm256_cmp_pd_mask(A, B, _CMP_LT_OQ);
+    }
+
+    inline FORCE_INLINE __int_vector _float_le_vec(const __float_vector A, const __float_vector B) {
+        return _mm256_cmp_ps_mask(A, B, _CMP_LE_OQ);
+    }
+
+    inline FORCE_INLINE __int_vector _double_le_vec(const __double_vector A, const __double_vector B) {
+        return _mm256_cmp_pd_mask(A, B, _CMP_LE_OQ);
+    }
+
+    inline FORCE_INLINE int _float_compress_storeu(float* addr, const __int_vector mask, const __float_vector A) {
+        _mm256_mask_compressstoreu_ps(addr, mask, A);
+        return __builtin_popcount(mask);
+    }
+
+    inline FORCE_INLINE int _double_compress_storeu(double* addr, const __int_vector mask, const __double_vector A) {
+        _mm256_mask_compressstoreu_pd(addr, mask, A);
+        return __builtin_popcount(mask & 0xF);
+    }
+
+    inline FORCE_INLINE __float_vector _float_reverse_vec(const __float_vector A) {
+        return _mm256_permutexvar_ps(_mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7), A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_reverse_vec(const __double_vector A) {
+        return _mm256_permutex_pd(A, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+
+    inline FORCE_INLINE __float_vector _float_bitonic_merge_vec(__float_vector A) {
+        __float_vector P = _mm256_shuffle_f32x4(A, A, 1);
+        A = _mm256_mask_max_ps(_mm256_min_ps(A, P), 0xF0, A, P);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm256_mask_max_ps(_mm256_min_ps(A, P), 0xCC, A, P);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm256_mask_max_ps(_mm256_min_ps(A, P), 0xAA, A, P);
+    }
+
+    inline FORCE_INLINE __double_vector _double_bitonic_merge_vec(__double_vector A) {
+        __double_vector P = _mm256_shuffle_f64x2(A, A, 1);
+        A = _mm256_mask_max_pd(_mm256_min_pd(A, P), 0xC, A, P);
+        P = _mm256_permute_pd(A, 0x5);
+        return _mm256_mask_max_pd(_mm256_min_pd(A, P), 0xA, A, P);
+    }
+
+    inline FORCE_INLINE __float_vector _float_sort_vec(__float_vector A) {
+        __float_vector P = _mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm256_mask_max_ps(_mm256_min_ps(A, P), 0x66, A, P);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm256_mask_max_ps(_mm256_min_ps(A, P), 0x3C, A, P);
+        P = _mm256_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm256_mask_max_ps(_mm256_min_ps(A, P), 0x5A, A, P);
+        return _float_bitonic_merge_vec(A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_sort_vec(__double_vector A) {
+        __double_vector P = _mm256_permute_pd(A, 0x5);
+        A = _mm256_mask_max_pd(_mm256_min_pd(A, P), 0x6, A, P);
+        return _double_bitonic_merge_vec(A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_blend_vec(const __float_vector A, const __float_vector B, const __int_vector mask) {
+        return _mm256_mask_blend_ps(mask, A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_blend_vec(const __double_vector A, const __double_vector B, const __int_vector mask) {
+        return _mm256_mask_blend_pd(mask, A, B);
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu(const int32_t* addr) {
+        return _mm256_loadu_si256((const __m256i*) addr);
+    }
+
+    inline FORCE_INLINE void _int32_storeu(int32_t* addr, const __int32_vector A) {
+        _mm256_storeu_si256((__m256i*) addr, A);
+    }
+
+    inline FORCE_INLINE __int32_vector _float_to_int32_vec(const __float_vector A) {
+        return _mm256_cvtps_epi32(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _float_trunc_int32_vec(const __float_vector A) {
+        return _mm256_cvttps_epi32(A);
+    }
+
+    inline FORCE_INLINE __float_vector _int32_to_float_vec(const __int32_vector A) {
+        return _mm256_cvtepi32_ps(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_u8(const uint8_t* addr) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) addr));
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_i8(const int8_t* addr) {
+        return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*) addr));
+    }
+
+    inline FORCE_INLINE void _int32_storeu_u8(uint8_t* addr, const __int32_vector A) {
+        _mm_storel_epi64((__m128i*) addr, _mm256_cvtusepi32_epi8(_mm256_max_epi32(A, _mm256_setzero_si256())));
+    }
+
+    inline FORCE_INLINE void _int32_storeu_i8(int8_t* addr, const __int32_vector A) {
+        _mm_storel_epi64((__m128i*) addr, _mm256_cvtsepi32_epi8(A));
+    }
+
+    inline FORCE_INLINE __float_vector _float_loadu_f16(const uint16_t* addr) {
+        return _mm256_maskz_cvtph_ps((__mmask8) 0xFF, _mm_loadu_si128((const __m128i*) addr));
+    }
+
+    inline FORCE_INLINE void _float_storeu_f16(uint16_t* addr, const __float_vector A) {
+        _mm_storeu_si128((__m128i*) addr, _mm256_maskz_cvtps_ph((__mmask8) 0xFF, A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_add_vec(const __int32_vector A, const __int32_vector B) {
+        return _mm256_add_epi32(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_gather_vec(const float* base, const __int32_vector idx) {
+        return _mm256_i32gather_ps(base, idx, 4);
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_loadu(const uint8_t* addr) {
+        return _mm256_loadu_si256((const __m256i*) addr);
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_set1_vec(uint8_t a) {
+        return _mm256_set1_epi8((char) a);
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_eq_vec(const __u8_vector A, const __u8_vector B) {
+        return _mm256_cmpeq_epi8_mask(A, B);
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_or_mask(const __u8_mask A, const __u8_mask B) {
+        return A | B;
+    }
+
+    inline FORCE_INLINE uint64_t _u8_movemask(const __u8_mask A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __float_vector _float_pow2_int32_vec(const __int32_vector n) {
+        return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+    }
+
+    inline FORCE_INLINE __float_vector _float_hsum_lanes_vec(const __float_vector* A) {
+        __m256 lo = _mm256_hadd_ps(_mm256_hadd_ps(A[0], A[1]), _mm256_hadd_ps(A[2], A[3]));
+        __m256 hi = _mm256_hadd_ps(_mm256_hadd_ps(A[4], A[5]), _mm256_hadd_ps(A[6], A[7]));
+        return _mm256_add_ps(_mm256_permute2f128_ps(lo, hi, 0x20), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+
+#elif defined(AVX512)
+/** AVX512 Support **/
+    #include <immintrin.h>
+    #include <avx512fintrin.h>
+
+    #define __float_vector __m512
+    #define __double_vector __m512d
+    #define __int_vector __mmask16
+    #define __int32_vector __m512i
+    #define __u8_vector __m512i
+    #define __u8_mask __mmask64
+    #define FLOAT_VEC_SIZE 16
+    #define DOUBLE_VEC_SIZE 8
+    #define U8_VEC_SIZE 64
+    #define SIMD_BACKEND "avx512"
+    #define simd_malloc(size) (alligned_malloc(512, size))
+
+    inline FORCE_INLINE void _float_storeu(float* addr, const __float_vector A) {
+        _mm512_storeu_ps(addr, A);
+    }
+
+    inline FORCE_INLINE void _double_storeu(double* addr, const __double_vector A) {
+        _mm512_storeu_pd(addr, A);
+    }
+
+    inline FORCE_INLINE void _float_store(float* addr, const __float_vector A) {
+        _mm512_stream_ps(addr, A);
+    }
+
+    inline FORCE_INLINE void _double_store(double* addr, const __double_vector A) {
+        _mm512_stream_pd(addr, A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_loadu(const float* addr) {
+        return _mm512_loadu_ps(addr);
+    }
+
+    inline FORCE_INLINE __double_vector _double_loadu(const double* addr) {
+        return _mm512_loadu_pd(addr);
+    }
+
+    inline FORCE_INLINE __int_vector _int_loadu(const void* addr) {
+        return *(const __int_vector*) addr;
+    }
+
+    inline FORCE_INLINE __float_vector _float_load(const float* addr) {
+        return _mm512_castsi512_ps(_mm512_stream_load_si512((void*) addr));
+    }
+
+    inline FORCE_INLINE __double_vector _double_load(const double* addr) {
+        return _mm512_castsi512_pd(_mm512_stream_load_si512((void*) addr));
+    }
+
+    inline FORCE_INLINE __float_vector _float_maskload(const float* addr, const __int_vector mask) {
+        return _mm512_mask_loadu_ps(_mm512_setzero_ps(), mask, addr);
+    }
+
+    inline FORCE_INLINE __double_vector _double_maskload(const double* addr, const __int_vector mask) {
+        return _mm512_mask_loadu_pd(_mm512_setzero_pd(), (__mmask8) mask, addr);
+    }
+
+    inline FORCE_INLINE void _float_maskstore(float* addr, const __int_vector mask, const __float_vector A) {
+        _mm512_mask_storeu_ps(addr, mask, A);
+    }
+
+    inline FORCE_INLINE void _double_maskstore(double* addr, const __int_vector mask, __double_vector A) {
+        _mm512_mask_storeu_pd(addr, mask, A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_loadu2(const double* A, const double* B) {
+        return _mm512_insertf64x4(_mm512_setzero_pd(), _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(A)), _mm_loadu_pd(B), 1), 0);
+    }
+
+    inline FORCE_INLINE __double_vector _double_loadu2_from_float(const float* A, const float* B) {
+        return _double_loadu((double[4]) {A[0], A[1], B[0], B[1]});
+    }
+
+    inline FORCE_INLINE __float_vector _float_add_vec(__float_vector A, __float_vector B) {
+        return _mm512_add_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_add_vec(__double_vector A, __double_vector B) {
+        return _mm512_add_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_sub_vec(__float_vector A, __float_vector B) {
+        return _mm512_sub_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_sub_vec(__double_vector A, __double_vector B) {
+        return _mm512_sub_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_mul_vec(__float_vector A, __float_vector B) {
+        return _mm512_mul_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_mul_vec(__double_vector A, __double_vector B) {
+        return _mm512_mul_pd(A, B);
+    }
+
+#ifndef SIMD_DETERMINISTIC
+    #define SIMD_FMA
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm512_fmadd_ps(A, B, C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm512_fmadd_pd(A, B, C);
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(__float_vector A, __float_vector B, __float_vector C) {
+        return _mm512_add_ps(_mm512_mul_ps(A, B), C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(__double_vector A, __double_vector B, __double_vector C) {
+        return _mm512_add_pd(_mm512_mul_pd(A, B), C);
+    }
+#endif
+
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
+    inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
+        return _mm512_mul_ps(A, _mm512_rcp14_ps(B));
+    }
+
+    inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
+        return _mm512_mul_pd(A, _mm512_rcp14_pd(B));
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_div_vec(__float_vector A, __float_vector B) {
+        return _mm512_div_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_div_vec(__double_vector A, __double_vector B) {
+        return _mm512_div_pd(A, B);
+    }
+#endif
+
+    inline FORCE_INLINE __float_vector _float_div_exact_vec(__float_vector A, __float_vector B) {
+        return _mm512_div_ps(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_set1_vec(float a) {
+        return _mm512_set1_ps(a);
+    }
+
+    inline FORCE_INLINE __double_vector _double_set1_vec(double a) {
+        return _mm512_set1_pd(a);
+    }
+
+    inline FORCE_INLINE __float_vector _float_set_vec(float a, float b, float c, float d, float e, float f, float g, float h, float i, float j, float k, float l, float m, float n, float o, float p) {
+        return _mm512_set_ps(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p);
+    }
+
+    inline FORCE_INLINE __double_vector _double_set_vec(double a, double b, double c, double d, double e, double f, double g, double h) {
+        return _mm512_set_pd(a, b, c, d, e, f, g, h);
+    }
+
+    inline FORCE_INLINE __float_vector _float_abs_vec(__float_vector x, __float_vector sign_mask) {
+        return _mm512_andnot_ps(sign_mask, x);
+    }
+
+    inline FORCE_INLINE __double_vector _double_abs_vec(__double_vector x, __double_vector sign_mask) {
+        return _mm512_andnot_pd(sign_mask, x);
+    }
+
+    inline FORCE_INLINE __float_vector _float_max_vec(__float_vector A, __float_vector B) {
+        return _mm512_max_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_max_vec(__double_vector A, __double_vector B) {
+        return _mm512_max_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_mask_max_vec(__float_vector A, __float_vector B, __int_vector mask) {
+        return _mm512_mask_max_ps(_mm512_set1_ps(-FLT_MAX), mask, A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_mask_max_vec(__double_vector A, __double_vector B, __int_vector mask) {
+        return _mm512_mask_max_pd(_mm512_set1_pd(-DBL_MAX), (__mmask8) mask, A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_min_vec(__float_vector A, __float_vector B) {
+        return _mm512_min_ps(A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_min_vec(__double_vector A, __double_vector B) {
+        return _mm512_min_pd(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_mask_min_vec(__float_vector A, __float_vector B, __int_vector mask) {
+        return _mm512_mask_min_ps(_mm512_set1_ps(FLT_MAX), mask, A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_mask_min_vec(__double_vector A, __double_vector B, __int_vector mask) {
+        return _mm512_mask_min_pd(_mm512_set1_pd(DBL_MAX), (__mmask8) mask, A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_setzero_vec() {
+        return _mm512_setzero_ps();
+    }
+
+    inline FORCE_INLINE __double_vector _double_setzero_vec() {
+        return _mm512_setzero_pd();
     }
 
     inline FORCE_INLINE float _float_index_vec(const __float_vector A, const int i) {
@@ -746,7 +1770,7 @@ int64_t float_next_aligned_pointer(const float* addr);
         return A[i];
     }
 
-#ifdef __FAST_MATH__
+#if defined(__FAST_MATH__) && !defined(SIMD_DETERMINISTIC)
     inline FORCE_INLINE __float_vector _float_recp_vec(const __float_vector A) {
         return _mm512_rcp14_ps(A);
     }
@@ -796,13 +1820,199 @@ int64_t float_next_aligned_pointer(const float* addr);
     }
 #endif
 
+    inline FORCE_INLINE __int_vector _float_lt_vec(const __float_vector A, const __float_vector B) {
+        return _mm512_cmp_ps_mask(A, B, _CMP_LT_OQ);
+    }
+
+    inline FORCE_INLINE __int_vector _double_lt_vec(const __double_vector A, const __double_vector B) {
+        return (__int_vector) _mm512_cmp_pd_mask(A, B, _CMP_LT_OQ);
+    }
+
+    inline FORCE_INLINE __int_vector _float_le_vec(const __float_vector A, const __float_vector B) {
+        return _mm512_cmp_ps_mask(A, B, _CMP_LE_OQ);
+    }
+
+    inline FORCE_INLINE __int_vector _double_le_vec(const __double_vector A, const __double_vector B) {
+        return (__int_vector) _mm512_cmp_pd_mask(A, B, _CMP_LE_OQ);
+    }
+
+    inline FORCE_INLINE int _float_compress_storeu(float* addr, const __int_vector mask, const __float_vector A) {
+        _mm512_mask_compressstoreu_ps(addr, mask, A);
+        return __builtin_popcount(mask);
+    }
+
+    inline FORCE_INLINE int _double_compress_storeu(double* addr, const __int_vector mask, const __double_vector A) {
+        _mm512_mask_compressstoreu_pd(addr, (__mmask8) mask, A);
+        return __builtin_popcount((__mmask8) mask);
+    }
+
+    inline FORCE_INLINE __float_vector _float_reverse_vec(const __float_vector A) {
+        return _mm512_permutexvar_ps(_mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_reverse_vec(const __double_vector A) {
+        return _mm512_permutexvar_pd(_mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7), A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_bitonic_merge_vec(__float_vector A) {
+        __float_vector P = _mm512_shuffle_f32x4(A, A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0xFF00, A, P);
+        P = _mm512_shuffle_f32x4(A, A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0xF0F0, A, P);
+        P = _mm512_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0xCCCC, A, P);
+        P = _mm512_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm512_mask_max_ps(_mm512_min_ps(A, P), 0xAAAA, A, P);
+    }
+
+    inline FORCE_INLINE __double_vector _double_bitonic_merge_vec(__double_vector A) {
+        __double_vector P = _mm512_shuffle_f64x2(A, A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm512_mask_max_pd(_mm512_min_pd(A, P), 0xF0, A, P);
+        P = _mm512_shuffle_f64x2(A, A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm512_mask_max_pd(_mm512_min_pd(A, P), 0xCC, A, P);
+        P = _mm512_permute_pd(A, 0x55);
+        return _mm512_mask_max_pd(_mm512_min_pd(A, P), 0xAA, A, P);
+    }
+
+    inline FORCE_INLINE __float_vector _float_sort_vec(__float_vector A) {
+        __float_vector P = _mm512_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0x6666, A, P);
+        P = _mm512_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0x3C3C, A, P);
+        P = _mm512_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0x5A5A, A, P);
+        P = _mm512_shuffle_f32x4(A, A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0x0FF0, A, P);
+        P = _mm512_permute_ps(A, _MM_SHUFFLE(1, 0, 3, 2));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0x33CC, A, P);
+        P = _mm512_permute_ps(A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm512_mask_max_ps(_mm512_min_ps(A, P), 0x55AA, A, P);
+        return _float_bitonic_merge_vec(A);
+    }
+
+    inline FORCE_INLINE __double_vector _double_sort_vec(__double_vector A) {
+        __double_vector P = _mm512_permute_pd(A, 0x55);
+        A = _mm512_mask_max_pd(_mm512_min_pd(A, P), 0x66, A, P);
+        P = _mm512_shuffle_f64x2(A, A, _MM_SHUFFLE(2, 3, 0, 1));
+        A = _mm512_mask_max_pd(_mm512_min_pd(A, P), 0x3C, A, P);
+        P = _mm512_permute_pd(A, 0x55);
+        A = _mm512_mask_max_pd(_mm512_min_pd(A, P), 0x5A, A, P);
+        return _double_bitonic_merge_vec(A);
+    }
+
+    inline FORCE_INLINE __float_vector _float_blend_vec(const __float_vector A, const __float_vector B, const __int_vector mask) {
+        return _mm512_mask_blend_ps(mask, A, B);
+    }
+
+    inline FORCE_INLINE __double_vector _double_blend_vec(const __double_vector A, const __double_vector B, const __int_vector mask) {
+        return _mm512_mask_blend_pd((__mmask8) mask, A, B);
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu(const int32_t* addr) {
+        return _mm512_loadu_si512(addr);
+    }
+
+    inline FORCE_INLINE void _int32_storeu(int32_t* addr, const __int32_vector A) {
+        _mm512_storeu_si512(addr, A);
+    }
+
+    inline FORCE_INLINE __int32_vector _float_to_int32_vec(const __float_vector A) {
+        return _mm512_cvtps_epi32(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _float_trunc_int32_vec(const __float_vector A) {
+        return _mm512_cvttps_epi32(A);
+    }
+
+    inline FORCE_INLINE __float_vector _int32_to_float_vec(const __int32_vector A) {
+        return _mm512_cvtepi32_ps(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_u8(const uint8_t* addr) {
+        return _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*) addr));
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_i8(const int8_t* addr) {
+        return _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*) addr));
+    }
+
+    inline FORCE_INLINE void _int32_storeu_u8(uint8_t* addr, const __int32_vector A) {
+        _mm_storeu_si128((__m128i*) addr, _mm512_cvtusepi32_epi8(_mm512_max_epi32(A, _mm512_setzero_si512())));
+    }
+
+    inline FORCE_INLINE void _int32_storeu_i8(int8_t* addr, const __int32_vector A) {
+        _mm_storeu_si128((__m128i*) addr, _mm512_cvtsepi32_epi8(A));
+    }
+
+    inline FORCE_INLINE __float_vector _float_loadu_f16(const uint16_t* addr) {
+        return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*) addr));
+    }
+
+    inline FORCE_INLINE void _float_storeu_f16(uint16_t* addr, const __float_vector A) {
+        _mm256_storeu_si256((__m256i*) addr, _mm512_cvtps_ph(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_add_vec(const __int32_vector A, const __int32_vector B) {
+        return _mm512_add_epi32(A, B);
+    }
+
+    inline FORCE_INLINE __float_vector _float_gather_vec(const float* base, const __int32_vector idx) {
+        return _mm512_i32gather_ps(idx, base, 4);
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_loadu(const uint8_t* addr) {
+        return _mm512_loadu_si512(addr);
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_set1_vec(uint8_t a) {
+        return _mm512_set1_epi8((char) a);
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_eq_vec(const __u8_vector A, const __u8_vector B) {
+        return _mm512_cmpeq_epi8_mask(A, B);
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_or_mask(const __u8_mask A, const __u8_mask B) {
+        return A | B;
+    }
+
+    inline FORCE_INLINE uint64_t _u8_movemask(const __u8_mask A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __float_vector _float_pow2_int32_vec(const __int32_vector n) {
+        return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(n, _mm512_set1_epi32(127)), 23));
+    }
+
+    inline FORCE_INLINE __float_vector _float_hsum_lanes_vec(const __float_vector* A) {
+        // Halve the width while doubling the vectors per register: 16 -> 8 -> 4,
+        // then finish each 128-bit lane like _MM_TRANSPOSE4_PS.
+        __m512 C[8], D[4];
+        for (int i = 0; i < 8; i++) {
+            C[i] = _mm512_add_ps(_mm512_shuffle_f32x4(A[i], A[i + 8], 0x44), _mm512_shuffle_f32x4(A[i], A[i + 8], 0xEE));
+        }
+        for (int i = 0; i < 4; i++) {
+            D[i] = _mm512_add_ps(_mm512_shuffle_f32x4(C[i], C[i + 4], 0x88), _mm512_shuffle_f32x4(C[i], C[i + 4], 0xDD));
+        }
+        __m512 u01 = _mm512_add_ps(_mm512_unpacklo_ps(D[0], D[1]), _mm512_unpackhi_ps(D[0], D[1]));
+        __m512 u23 = _mm512_add_ps(_mm512_unpacklo_ps(D[2], D[3]), _mm512_unpackhi_ps(D[2], D[3]));
+        __m512 F = _mm512_add_ps(_mm512_shuffle_ps(u01, u23, 0x44), _mm512_shuffle_ps(u01, u23, 0xEE));
+        // 128-bit lanes now hold A[0..3], A[8..11], A[4..7], A[12..15].
+        return _mm512_shuffle_f32x4(F, F, 0xD8);
+    }
+
 #else
 /** No SIMD Support **/
     #define __int_vector int
+    #define __int32_vector int32_t
+    #define __u8_vector uint8_t
+    #define __u8_mask int
     #define __float_vector float
     #define __double_vector double
     #define FLOAT_VEC_SIZE 1
     #define DOUBLE_VEC_SIZE 1
+    #define U8_VEC_SIZE 1
+    #define SIMD_BACKEND "scalar"
     #define simd_malloc malloc
 
     inline FORCE_INLINE void _float_store(float* addr, const __float_vector A) {
@@ -881,10 +2091,34 @@ int64_t float_next_aligned_pointer(const float* addr);
         return A*B;
     }
 
+#if defined(__FMA__) && !defined(SIMD_DETERMINISTIC)
+    #define SIMD_FMA
+
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(const __float_vector A, const __float_vector B, const __float_vector C) {
+        return fmaf(A, B, C);
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(const __double_vector A, const __double_vector B, const __double_vector C) {
+        return fma(A, B, C);
+    }
+#else
+    inline FORCE_INLINE __float_vector _float_fmadd_vec(const __float_vector A, const __float_vector B, const __float_vector C) {
+        return A*B+C;
+    }
+
+    inline FORCE_INLINE __double_vector _double_fmadd_vec(const __double_vector A, const __double_vector B, const __double_vector C) {
+        return A*B+C;
+    }
+#endif
+
     inline FORCE_INLINE __float_vector _float_div_vec(const __float_vector A, const __float_vector B) {
         return A/B;
     }
 
+    inline FORCE_INLINE __float_vector _float_div_exact_vec(const __float_vector A, const __float_vector B) {
+        return A/B;
+    }
+
     inline FORCE_INLINE __double_vector _double_div_vec(const __double_vector A, const __double_vector B) {
         return A/B;
     }
@@ -976,4 +2210,298 @@ int64_t float_next_aligned_pointer(const float* addr);
     inline FORCE_INLINE __double_vector _double_sqrt_vec(const __double_vector A) {
         return sqrt(A);
     }
+
+    inline FORCE_INLINE __int_vector _float_lt_vec(const __float_vector A, const __float_vector B) {
+        return A < B;
+    }
+
+    inline FORCE_INLINE __int_vector _double_lt_vec(const __double_vector A, const __double_vector B) {
+        return A < B;
+    }
+
+    inline FORCE_INLINE __int_vector _float_le_vec(const __float_vector A, const __float_vector B) {
+        return A <= B;
+    }
+
+    inline FORCE_INLINE __int_vector _double_le_vec(const __double_vector A, const __double_vector B) {
+        return A <= B;
+    }
+
+    inline FORCE_INLINE int _float_compress_storeu(float* addr, const __int_vector mask, const __float_vector A) {
+        mask != 0 ? addr[0] = A: 0;
+        return mask != 0;
+    }
+
+    inline FORCE_INLINE int _double_compress_storeu(double* addr, const __int_vector mask, const __double_vector A) {
+        mask != 0 ? addr[0] = A: 0;
+        return mask != 0;
+    }
+
+    inline FORCE_INLINE __float_vector _float_reverse_vec(const __float_vector A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __double_vector _double_reverse_vec(const __double_vector A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __float_vector _float_bitonic_merge_vec(const __float_vector A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __double_vector _double_bitonic_merge_vec(const __double_vector A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __float_vector _float_sort_vec(const __float_vector A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __double_vector _double_sort_vec(const __double_vector A) {
+        return A;
+    }
+
+    inline FORCE_INLINE __float_vector _float_blend_vec(const __float_vector A, const __float_vector B, const __int_vector mask) {
+        return mask != 0 ? B : A;
+    }
+
+    inline FORCE_INLINE __double_vector _double_blend_vec(const __double_vector A, const __double_vector B, const __int_vector mask) {
+        return mask != 0 ? B : A;
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu(const int32_t* addr) {
+        return addr[0];
+    }
+
+    inline FORCE_INLINE void _int32_storeu(int32_t* addr, const __int32_vector A) {
+        addr[0] = A;
+    }
+
+    inline FORCE_INLINE __int32_vector _float_to_int32_vec(const __float_vector A) {
+        return (int32_t) lrintf(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _float_trunc_int32_vec(const __float_vector A) {
+        return (int32_t) A;
+    }
+
+    inline FORCE_INLINE __float_vector _int32_to_float_vec(const __int32_vector A) {
+        return (float) A;
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_u8(const uint8_t* addr) {
+        return addr[0];
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_loadu_i8(const int8_t* addr) {
+        return addr[0];
+    }
+
+    inline FORCE_INLINE void _int32_storeu_u8(uint8_t* addr, const __int32_vector A) {
+        addr[0] = (uint8_t) min(max(A, 0), UINT8_MAX);
+    }
+
+    inline FORCE_INLINE void _int32_storeu_i8(int8_t* addr, const __int32_vector A) {
+        addr[0] = (int8_t) min(max(A, INT8_MIN), INT8_MAX);
+    }
+
+    inline FORCE_INLINE __float_vector _float_loadu_f16(const uint16_t* addr) {
+        return f16_to_float(addr[0]);
+    }
+
+    inline FORCE_INLINE void _float_storeu_f16(uint16_t* addr, const __float_vector A) {
+        addr[0] = float_to_f16(A);
+    }
+
+    inline FORCE_INLINE __int32_vector _int32_add_vec(const __int32_vector A, const __int32_vector B) {
+        return A+B;
+    }
+
+    inline FORCE_INLINE __float_vector _float_gather_vec(const float* base, const __int32_vector idx) {
+        return base[idx];
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_loadu(const uint8_t* addr) {
+        return addr[0];
+    }
+
+    inline FORCE_INLINE __u8_vector _u8_set1_vec(uint8_t a) {
+        return a;
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_eq_vec(const __u8_vector A, const __u8_vector B) {
+        return A == B;
+    }
+
+    inline FORCE_INLINE __u8_mask _u8_or_mask(const __u8_mask A, const __u8_mask B) {
+        return A | B;
+    }
+
+    inline FORCE_INLINE uint64_t _u8_movemask(const __u8_mask A) {
+        return (uint64_t) A;
+    }
+
+    inline FORCE_INLINE __float_vector _float_pow2_int32_vec(const __int32_vector n) {
+        return ldexpf(1.f, n);
+    }
+
+    inline FORCE_INLINE __float_vector _float_hsum_lanes_vec(const __float_vector* A) {
+        return A[0];
+    }
+#endif
+
+/** Backend Independent Helpers **/
+
+/**
+ * Software Prefetch Hints, Strongest Locality Last
+ */
+#define SIMD_PREFETCH_NTA 0
+#define SIMD_PREFETCH_T2 1
+#define SIMD_PREFETCH_T1 2
+#define SIMD_PREFETCH_T0 3
+#define SIMD_CACHE_LINE 64
+
+/**
+ * Prefetch The Cache Line Holding addr; hint Must Be A Compile Time Constant
+ */
+#ifdef _MSC_VER
+    #define _simd_prefetch(addr, hint) \
+        _mm_prefetch((const char*) (addr), (hint) == SIMD_PREFETCH_T0 ? _MM_HINT_T0 : \
+                                           (hint) == SIMD_PREFETCH_T1 ? _MM_HINT_T1 : \
+                                           (hint) == SIMD_PREFETCH_T2 ? _MM_HINT_T2 : _MM_HINT_NTA)
+#else
+    #define _simd_prefetch(addr, hint) __builtin_prefetch((const void*) (addr), 0, (hint))
+#endif
+
+/**
+ * Order Non-Temporal Stores (_float_store, _double_store) Before Later Stores
+ */
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #include <xmmintrin.h>
+    #define _simd_store_fence() _mm_sfence()
+#else
+    #define _simd_store_fence()
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+/**
+ * Index Of The Lowest Set Bit; bits Must Be Non-Zero
+ */
+inline FORCE_INLINE int _u8_bitscan(const uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward64(&i, bits);
+    return (int) i;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+/**
+ * Number Of Set Bits
+ */
+inline FORCE_INLINE int _u8_popcount(const uint64_t bits) {
+#ifdef _MSC_VER
+    return (int) __popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
 #endif
+}
+
+extern const float float_lane_index[16];
+
+/**
+ * Mask Of The First n Lanes, For Masked Loads And Stores Of A Tail
+ */
+inline FORCE_INLINE __int_vector _float_lane_mask(const int n) {
+    return _float_lt_vec(_float_loadu(float_lane_index), _float_set1_vec((float) n));
+}
+
+inline FORCE_INLINE float _float_hmin_vec(const __float_vector A) {
+    float lanes[FLOAT_VEC_SIZE];
+    _float_storeu(lanes, A);
+    float r = lanes[0];
+    for (int i = 1; i < FLOAT_VEC_SIZE; i++) {
+        r = min(r, lanes[i]);
+    }
+    return r;
+}
+
+inline FORCE_INLINE float _float_hmax_vec(const __float_vector A) {
+    float lanes[FLOAT_VEC_SIZE];
+    _float_storeu(lanes, A);
+    float r = lanes[0];
+    for (int i = 1; i < FLOAT_VEC_SIZE; i++) {
+        r = max(r, lanes[i]);
+    }
+    return r;
+}
+
+inline FORCE_INLINE float _float_hsum_vec(const __float_vector A) {
+    float lanes[FLOAT_VEC_SIZE];
+    _float_storeu(lanes, A);
+    float r = lanes[0];
+    for (int i = 1; i < FLOAT_VEC_SIZE; i++) {
+        r += lanes[i];
+    }
+    return r;
+}
+
+inline FORCE_INLINE double _double_hsum_vec(const __double_vector A) {
+    double lanes[DOUBLE_VEC_SIZE];
+    _double_storeu(lanes, A);
+    double r = lanes[0];
+    for (int i = 1; i < DOUBLE_VEC_SIZE; i++) {
+        r += lanes[i];
+    }
+    return r;
+}
+
+/**
+ * Combine SIMD_CANON_LANES Virtual Lanes By The Fixed Pairwise Tree Of SIMD_DETERMINISTIC
+ * @param lanes overwritten
+ * @return
+ */
+inline FORCE_INLINE float _float_canon_fold(float* lanes) {
+    for (int step = 1; step < SIMD_CANON_LANES; step *= 2) {
+        for (int k = 0; k < SIMD_CANON_LANES; k += 2*step) {
+            lanes[k] += lanes[k + step];
+        }
+    }
+    return lanes[0];
+}
+
+inline FORCE_INLINE double _double_canon_fold(double* lanes) {
+    for (int step = 1; step < SIMD_CANON_LANES; step *= 2) {
+        for (int k = 0; k < SIMD_CANON_LANES; k += 2*step) {
+            lanes[k] += lanes[k + step];
+        }
+    }
+    return lanes[0];
+}
+
+/**
+ * e^A Within 3 ulp (Cephes Polynomial); Results Below FLT_MIN Flush To Zero
+ */
+inline FORCE_INLINE __float_vector _float_exp_vec(const __float_vector A) {
+    __float_vector t = _float_mul_vec(A, _float_set1_vec(1.44269504f));
+    t = _float_min_vec(_float_max_vec(t, _float_set1_vec(-126.f)), _float_set1_vec(127.f));
+    __int32_vector n = _float_to_int32_vec(t);
+    __float_vector f = _int32_to_float_vec(n);
+    // ln 2 split in two so f * hi is exact without FMA.
+    __float_vector r = _float_fmadd_vec(f, _float_set1_vec(-0.693359375f), A);
+    r = _float_fmadd_vec(f, _float_set1_vec(2.12194440e-4f), r);
+
+    __float_vector p = _float_set1_vec(1.9875691500e-4f);
+    p = _float_fmadd_vec(p, r, _float_set1_vec(1.3981999507e-3f));
+    p = _float_fmadd_vec(p, r, _float_set1_vec(8.3334519073e-3f));
+    p = _float_fmadd_vec(p, r, _float_set1_vec(4.1665795894e-2f));
+    p = _float_fmadd_vec(p, r, _float_set1_vec(1.6666665459e-1f));
+    p = _float_fmadd_vec(p, r, _float_set1_vec(5.0000001201e-1f));
+    p = _float_fmadd_vec(p, _float_mul_vec(r, r), _float_add_vec(r, _float_set1_vec(1.f)));
+    p = _float_mul_vec(p, _float_pow2_int32_vec(n));
+    return _float_blend_vec(p, _float_setzero_vec(), _float_lt_vec(A, _float_set1_vec(-87.33654f)));
+}
@@ -0,0 +1,541 @@
+#include "simd_activation.h"
+#include "simd_instrument.h"
+#include "simd_reduce.h"
+
+#define ROW_MAX (ACTIVATION_REG_VECS * FLOAT_VEC_SIZE)
+#define WELFORD_BLOCK 4
+#define WELFORD_CHUNK 64
+
+/**
+ * A Short Row Held In Registers; Lanes Past len In The Last Vector Are 0
+ */
+typedef struct {
+    __float_vector x[ACTIVATION_REG_VECS];
+    __int_vector last;
+    int nvec;
+} act_row;
+
+static inline FORCE_INLINE void row_load(act_row* r, const float* in, int len) {
+    r->nvec = (len + FLOAT_VEC_SIZE - 1) / FLOAT_VEC_SIZE;
+    r->last = _float_lane_mask(len - (r->nvec - 1) * FLOAT_VEC_SIZE);
+    for (int v = 0; v < r->nvec - 1; v++) {
+        r->x[v] = _float_loadu(in + v * FLOAT_VEC_SIZE);
+    }
+    r->x[r->nvec - 1] = _float_maskload(in + (r->nvec - 1) * FLOAT_VEC_SIZE, r->last);
+}
+
+static inline FORCE_INLINE void row_store(const act_row* r, float* out) {
+    for (int v = 0; v < r->nvec - 1; v++) {
+        _float_storeu(out + v * FLOAT_VEC_SIZE, r->x[v]);
+    }
+    _float_maskstore(out + (r->nvec - 1) * FLOAT_VEC_SIZE, r->last, r->x[r->nvec - 1]);
+}
+
+static float act_recp(float a, activation_mode mode) {
+    if (mode == ACTIVATION_ACCURATE) {
+        return 1.f / a;
+    }
+    float lanes[FLOAT_VEC_SIZE];
+    _float_storeu(lanes, _float_recp_vec(_float_set1_vec(a)));
+    return lanes[0];
+}
+
+static float act_rsqrt(float a, activation_mode mode) {
+    if (mode == ACTIVATION_ACCURATE) {
+        return 1.f / sqrtf(a);
+    }
+    float lanes[FLOAT_VEC_SIZE];
+    _float_storeu(lanes, _float_rsqrt_vec(_float_set1_vec(a)));
+    return lanes[0];
+}
+
+/**
+ * ACTIVATION_FAST: The Exponent Is Split Off And log(m), m In [sqrt(1/2), sqrt(2)),
+ * Is 2 atanh((m - 1) / (m + 1)) To Three Terms; Within 3e-6 For Softmax Sums
+ * (1 To The Row Length). Zero, Subnormal, Infinite And NaN Go To logf
+ */
+static float act_log(float a, activation_mode mode) {
+    if (mode == ACTIVATION_ACCURATE || !(a >= FLT_MIN && a <= FLT_MAX)) {
+        return logf(a);
+    }
+    uint32_t bits;
+    memcpy(&bits, &a, sizeof(bits));
+    int e = (int) (bits >> 23) - 127;
+    bits = (bits & 0x7fffff) | 0x3f800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    if (m > 1.41421356f) {
+        m *= 0.5f;
+        e++;
+    }
+    float t = (m - 1.f) / (m + 1.f);
+    float t2 = t * t;
+    return e * 0.693147181f + 2.f * t * (1.f + t2 * (1.f / 3.f + t2 * (1.f / 5.f)));
+}
+
+/** Softmax **/
+
+/**
+ * Online Max And Sum: Each Lane Keeps Its Running Max M And The Sum S Of
+ * e^(x - M), Rescaling S Once Per Block Of Four Vectors When M Grows
+ */
+#ifdef SIMD_DETERMINISTIC
+/**
+ * Canonical Order Sum Of e^(x - m): Whole Groups Of SIMD_CANON_LANES Through
+ * Vectors, The Rest Added To Their Lanes, With The Same _float_exp_vec
+ */
+static float canon_sum_exp(const float* in, int len, float m) {
+    __float_vector M = _float_set1_vec(m);
+    __float_vector S[FLOAT_CANON_VECS];
+    float lanes[SIMD_CANON_LANES];
+    int i = 0;
+    for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+        S[k] = _float_setzero_vec();
+    }
+    for (; i + SIMD_CANON_LANES <= len; i += SIMD_CANON_LANES) {
+        for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+            S[k] = _float_add_vec(S[k], _float_exp_vec(_float_sub_vec(_float_loadu(in + i + k * FLOAT_VEC_SIZE), M)));
+        }
+    }
+    for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+        _float_storeu(lanes + k * FLOAT_VEC_SIZE, S[k]);
+    }
+    for (; i < len; i += FLOAT_VEC_SIZE) {
+        float e[FLOAT_VEC_SIZE];
+        _float_storeu(e, _float_exp_vec(_float_sub_vec(_float_maskload(in + i, _float_lane_mask(len - i)), M)));
+        for (int l = 0; l < min(FLOAT_VEC_SIZE, len - i); l++) {
+            lanes[(i + l) % SIMD_CANON_LANES] += e[l];
+        }
+    }
+    return _float_canon_fold(lanes);
+}
+#endif
+
+static void softmax_stats(const float* in, int len, float* max_out, float* sum_out) {
+#ifdef SIMD_DETERMINISTIC
+    // The maximum is exact in any order; only the sum needs the canonical order.
+    __float_vector M = _float_set1_vec(-INFINITY);
+    int j = 0;
+    for (; j + FLOAT_VEC_SIZE <= len; j += FLOAT_VEC_SIZE) {
+        M = _float_max_vec(M, _float_loadu(in + j));
+    }
+    if (j < len) {
+        __int_vector mask = _float_lane_mask(len - j);
+        M = _float_max_vec(M, _float_blend_vec(M, _float_maskload(in + j, mask), mask));
+    }
+    *max_out = _float_hmax_vec(M);
+    *sum_out = canon_sum_exp(in, len, *max_out);
+#else
+    __float_vector ninf = _float_set1_vec(-INFINITY);
+    __float_vector M = _float_set1_vec(-FLT_MAX);
+    __float_vector S = _float_setzero_vec();
+    int i = 0;
+    for (; i + 4 * FLOAT_VEC_SIZE <= len; i += 4 * FLOAT_VEC_SIZE) {
+        __float_vector A0 = _float_loadu(in + i);
+        __float_vector A1 = _float_loadu(in + i + FLOAT_VEC_SIZE);
+        __float_vector A2 = _float_loadu(in + i + 2 * FLOAT_VEC_SIZE);
+        __float_vector A3 = _float_loadu(in + i + 3 * FLOAT_VEC_SIZE);
+        __float_vector N = _float_max_vec(M, _float_max_vec(_float_max_vec(A0, A1), _float_max_vec(A2, A3)));
+        S = _float_mul_vec(S, _float_exp_vec(_float_sub_vec(M, N)));
+        S = _float_add_vec(S, _float_add_vec(_float_exp_vec(_float_sub_vec(A0, N)), _float_exp_vec(_float_sub_vec(A1, N))));
+        S = _float_add_vec(S, _float_add_vec(_float_exp_vec(_float_sub_vec(A2, N)), _float_exp_vec(_float_sub_vec(A3, N))));
+        M = N;
+    }
+    for (; i < len; i += FLOAT_VEC_SIZE) {
+        __float_vector A;
+        if (i + FLOAT_VEC_SIZE <= len) {
+            A = _float_loadu(in + i);
+        } else {
+            __int_vector mask = _float_lane_mask(len - i);
+            A = _float_blend_vec(ninf, _float_maskload(in + i, mask), mask);
+        }
+        __float_vector N = _float_max_vec(M, A);
+        S = _float_fmadd_vec(S, _float_exp_vec(_float_sub_vec(M, N)), _float_exp_vec(_float_sub_vec(A, N)));
+        M = N;
+    }
+
+    float m = _float_hmax_vec(M);
+    *max_out = m;
+    *sum_out = _float_hsum_vec(_float_mul_vec(S, _float_exp_vec(_float_sub_vec(M, _float_set1_vec(m)))));
+#endif
+}
+
+void float_softmax(const float* in, float* out, int len, activation_mode mode) {
+    SIMD_PROBE("float_softmax", len);
+    if (len <= 0) {
+        return;
+    }
+
+#ifndef SIMD_DETERMINISTIC
+    if (len <= ROW_MAX) {
+        act_row r;
+        row_load(&r, in, len);
+        r.x[r.nvec - 1] = _float_blend_vec(_float_set1_vec(-INFINITY), r.x[r.nvec - 1], r.last);
+        __float_vector M = r.x[0];
+        for (int v = 1; v < r.nvec; v++) {
+            M = _float_max_vec(M, r.x[v]);
+        }
+        M = _float_set1_vec(_float_hmax_vec(M));
+        __float_vector S = _float_setzero_vec();
+        for (int v = 0; v < r.nvec; v++) {
+            r.x[v] = _float_exp_vec(_float_sub_vec(r.x[v], M));
+            S = _float_add_vec(S, r.x[v]);
+        }
+        __float_vector inv = _float_set1_vec(act_recp(_float_hsum_vec(S), mode));
+        for (int v = 0; v < r.nvec; v++) {
+            r.x[v] = _float_mul_vec(r.x[v], inv);
+        }
+        row_store(&r, out);
+        return;
+    }
+#endif
+
+    float m, s;
+    softmax_stats(in, len, &m, &s);
+    __float_vector M = _float_set1_vec(m);
+    __float_vector inv = _float_set1_vec(act_recp(s, mode));
+    int i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, _float_mul_vec(_float_exp_vec(_float_sub_vec(_float_loadu(in + i), M)), inv));
+    }
+    if (i < len) {
+        __int_vector mask = _float_lane_mask(len - i);
+        _float_maskstore(out + i, mask, _float_mul_vec(_float_exp_vec(_float_sub_vec(_float_maskload(in + i, mask), M)), inv));
+    }
+}
+
+void float_log_softmax(const float* in, float* out, int len, activation_mode mode) {
+    SIMD_PROBE("float_log_softmax", len);
+    if (len <= 0) {
+        return;
+    }
+
+#ifndef SIMD_DETERMINISTIC
+    if (len <= ROW_MAX) {
+        act_row r;
+        row_load(&r, in, len);
+        __float_vector ninf = _float_set1_vec(-INFINITY);
+        __float_vector M = _float_blend_vec(ninf, r.x[r.nvec - 1], r.last);
+        for (int v = 0; v < r.nvec - 1; v++) {
+            M = _float_max_vec(M, r.x[v]);
+        }
+        float m = _float_hmax_vec(M);
+        M = _float_set1_vec(m);
+        __float_vector S = _float_blend_vec(_float_setzero_vec(), _float_exp_vec(_float_sub_vec(r.x[r.nvec - 1], M)), r.last);
+        for (int v = 0; v < r.nvec - 1; v++) {
+            S = _float_add_vec(S, _float_exp_vec(_float_sub_vec(r.x[v], M)));
+        }
+        __float_vector C = _float_set1_vec(m + act_log(_float_hsum_vec(S), mode));
+        for (int v = 0; v < r.nvec; v++) {
+            r.x[v] = _float_sub_vec(r.x[v], C);
+        }
+        row_store(&r, out);
+        return;
+    }
+#endif
+
+    float m, s;
+    softmax_stats(in, len, &m, &s);
+    __float_vector C = _float_set1_vec(m + act_log(s, mode));
+    int i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, _float_sub_vec(_float_loadu(in + i), C));
+    }
+    if (i < len) {
+        __int_vector mask = _float_lane_mask(len - i);
+        _float_maskstore(out + i, mask, _float_sub_vec(_float_maskload(in + i, mask), C));
+    }
+}
+
+/** Normalization **/
+
+/**
+ * (x - center) * scale * gamma + beta For The Vector At Offset i; Subtracting
+ * First Avoids The Cancellation Of x * scale - center * scale
+ */
+static inline FORCE_INLINE __float_vector affine_vec(const __float_vector X, const __float_vector center, const __float_vector scale,
+                                                     const float* gamma, const float* beta, int i, const __int_vector mask, bool full) {
+    __float_vector Y = _float_mul_vec(_float_sub_vec(X, center), scale);
+    if (gamma != NULL) {
+        Y = _float_mul_vec(Y, full ? _float_loadu(gamma + i) : _float_maskload(gamma + i, mask));
+    }
+    if (beta != NULL) {
+        Y = _float_add_vec(Y, full ? _float_loadu(beta + i) : _float_maskload(beta + i, mask));
+    }
+    return Y;
+}
+
+#ifndef SIMD_DETERMINISTIC
+static void affine_row(act_row* r, float center, float scale, const float* gamma, const float* beta) {
+    __float_vector A = _float_set1_vec(center);
+    __float_vector B = _float_set1_vec(scale);
+    for (int v = 0; v < r->nvec; v++) {
+        r->x[v] = affine_vec(r->x[v], A, B, gamma, beta, v * FLOAT_VEC_SIZE, r->last, v < r->nvec - 1);
+    }
+}
+#endif
+
+static void affine(const float* in, float* out, int len, float center, float scale, const float* gamma, const float* beta) {
+    __float_vector A = _float_set1_vec(center);
+    __float_vector B = _float_set1_vec(scale);
+    __int_vector mask = _float_lane_mask(len % FLOAT_VEC_SIZE);
+    int i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, affine_vec(_float_loadu(in + i), A, B, gamma, beta, i, mask, true));
+    }
+    if (i < len) {
+        _float_maskstore(out + i, mask, affine_vec(_float_maskload(in + i, mask), A, B, gamma, beta, i, mask, false));
+    }
+}
+
+#ifndef SIMD_DETERMINISTIC
+static void welford_merge(double* mean, double* m2, double* n, double mean_b, double m2_b, double n_b) {
+    double total = *n + n_b;
+    double delta = mean_b - *mean;
+    *mean += delta * n_b / total;
+    *m2 += m2_b + delta * delta * *n * n_b / total;
+    *n = total;
+}
+
+/**
+ * Per Lane Statistics Over Blocks Of WELFORD_BLOCK Vectors (Chan et al.);
+ * Every WELFORD_CHUNK Samples Per Lane The Lanes Are Merged Into Double
+ * Totals, So Rounding In The Float Running Mean Cannot Build Up
+ */
+static void layernorm_stats_welford(const float* in, int len, float* mean_out, float* var_out) {
+    const int step = WELFORD_BLOCK * FLOAT_VEC_SIZE;
+    double mu = 0.;
+    double M2 = 0.;
+    double total = 0.;
+    int i = 0;
+    while (i + step <= len) {
+        __float_vector mean = _float_setzero_vec();
+        __float_vector m2 = _float_setzero_vec();
+        int n = 0;
+        for (; i + step <= len && n < WELFORD_CHUNK; i += step) {
+            __float_vector A0 = _float_loadu(in + i);
+            __float_vector A1 = _float_loadu(in + i + FLOAT_VEC_SIZE);
+            __float_vector A2 = _float_loadu(in + i + 2 * FLOAT_VEC_SIZE);
+            __float_vector A3 = _float_loadu(in + i + 3 * FLOAT_VEC_SIZE);
+            __float_vector B = _float_mul_vec(_float_add_vec(_float_add_vec(A0, A1), _float_add_vec(A2, A3)), _float_set1_vec(0.25f));
+            __float_vector D0 = _float_sub_vec(A0, B);
+            __float_vector D1 = _float_sub_vec(A1, B);
+            __float_vector D2 = _float_sub_vec(A2, B);
+            __float_vector D3 = _float_sub_vec(A3, B);
+            __float_vector B2 = _float_fmadd_vec(D0, D0, _float_fmadd_vec(D1, D1, _float_fmadd_vec(D2, D2, _float_mul_vec(D3, D3))));
+
+            float merged = (float) (n + WELFORD_BLOCK);
+            __float_vector delta = _float_sub_vec(B, mean);
+            mean = _float_fmadd_vec(delta, _float_set1_vec(WELFORD_BLOCK / merged), mean);
+            m2 = _float_add_vec(m2, _float_fmadd_vec(_float_mul_vec(delta, delta), _float_set1_vec(n * WELFORD_BLOCK / merged), B2));
+            n += WELFORD_BLOCK;
+        }
+
+        float lm[FLOAT_VEC_SIZE];
+        float l2[FLOAT_VEC_SIZE];
+        _float_storeu(lm, mean);
+        _float_storeu(l2, m2);
+        for (int l = 0; l < FLOAT_VEC_SIZE; l++) {
+            welford_merge(&mu, &M2, &total, lm[l], l2[l], n);
+        }
+    }
+    for (; i < len; i++) {
+        welford_merge(&mu, &M2, &total, in[i], 0., 1.);
+    }
+    *mean_out = (float) mu;
+    *var_out = (float) (M2 / len);
+}
+
+/**
+ * Sums Of (x - in[0]) And Its Square In One Pass; Shifting By A Sample Keeps
+ * The Cancellation In s2 - s1^2 / n Small Unless in[0] Is An Outlier
+ */
+static void layernorm_stats_shifted(const float* in, int len, float* mean_out, float* var_out) {
+    __float_vector shift = _float_set1_vec(in[0]);
+    __float_vector S1a = _float_setzero_vec(), S1b = _float_setzero_vec();
+    __float_vector S2a = _float_setzero_vec(), S2b = _float_setzero_vec();
+    int i = 0;
+    for (; i + 2 * FLOAT_VEC_SIZE <= len; i += 2 * FLOAT_VEC_SIZE) {
+        __float_vector D0 = _float_sub_vec(_float_loadu(in + i), shift);
+        __float_vector D1 = _float_sub_vec(_float_loadu(in + i + FLOAT_VEC_SIZE), shift);
+        S1a = _float_add_vec(S1a, D0);
+        S1b = _float_add_vec(S1b, D1);
+        S2a = _float_fmadd_vec(D0, D0, S2a);
+        S2b = _float_fmadd_vec(D1, D1, S2b);
+    }
+    for (; i < len; i += FLOAT_VEC_SIZE) {
+        __int_vector mask = _float_lane_mask(len - i);
+        __float_vector D = _float_blend_vec(_float_setzero_vec(), _float_sub_vec(_float_maskload(in + i, mask), shift), mask);
+        S1a = _float_add_vec(S1a, D);
+        S2a = _float_fmadd_vec(D, D, S2a);
+    }
+    float s1 = _float_hsum_vec(_float_add_vec(S1a, S1b)) / len;
+    float s2 = _float_hsum_vec(_float_add_vec(S2a, S2b)) / len;
+    *mean_out = in[0] + s1;
+    *var_out = max(s2 - s1 * s1, 0.f);
+}
+#endif
+
+void float_layernorm(const float* in, float* out, int len, const float* gamma, const float* beta, float eps, activation_mode mode) {
+    SIMD_PROBE("float_layernorm", len);
+    if (len <= 0) {
+        return;
+    }
+
+#ifndef SIMD_DETERMINISTIC
+    if (len <= ROW_MAX) {
+        // Exact two pass statistics, both over registers.
+        act_row r;
+        row_load(&r, in, len);
+        __float_vector S = r.x[0];
+        for (int v = 1; v < r.nvec; v++) {
+            S = _float_add_vec(S, r.x[v]);
+        }
+        float mean = _float_hsum_vec(S) / len;
+        __float_vector M = _float_set1_vec(mean);
+        __float_vector D = _float_blend_vec(_float_setzero_vec(), _float_sub_vec(r.x[r.nvec - 1], M), r.last);
+        S = _float_mul_vec(D, D);
+        for (int v = 0; v < r.nvec - 1; v++) {
+            D = _float_sub_vec(r.x[v], M);
+            S = _float_fmadd_vec(D, D, S);
+        }
+        float rstd = act_rsqrt(_float_hsum_vec(S) / len + eps, mode);
+        affine_row(&r, mean, rstd, gamma, beta);
+        row_store(&r, out);
+        return;
+    }
+#endif
+
+    float mean, var;
+#ifdef SIMD_DETERMINISTIC
+    mean = float_sum_canonical(in, len) / len;
+    var = float_sumsq_canonical(in, len, mean) / len;
+#else
+    if (mode == ACTIVATION_ACCURATE) {
+        layernorm_stats_welford(in, len, &mean, &var);
+    } else {
+        layernorm_stats_shifted(in, len, &mean, &var);
+    }
+#endif
+    float rstd = act_rsqrt(var + eps, mode);
+    affine(in, out, len, mean, rstd, gamma, beta);
+}
+
+void float_rmsnorm(const float* in, float* out, int len, const float* gamma, float eps, activation_mode mode) {
+    SIMD_PROBE("float_rmsnorm", len);
+    if (len <= 0) {
+        return;
+    }
+
+#ifdef SIMD_DETERMINISTIC
+    affine(in, out, len, 0.f, act_rsqrt(float_sumsq_canonical(in, len, 0.f) / len + eps, mode), gamma, NULL);
+    return;
+#else
+    if (len <= ROW_MAX) {
+        act_row r;
+        row_load(&r, in, len);
+        __float_vector S = _float_setzero_vec();
+        for (int v = 0; v < r.nvec; v++) {
+            S = _float_fmadd_vec(r.x[v], r.x[v], S);
+        }
+        affine_row(&r, 0.f, act_rsqrt(_float_hsum_vec(S) / len + eps, mode), gamma, NULL);
+        row_store(&r, out);
+        return;
+    }
+#endif
+    __float_vector S0 = _float_setzero_vec(), S1 = _float_setzero_vec();
+    __float_vector S2 = _float_setzero_vec(), S3 = _float_setzero_vec();
+    int i = 0;
+    for (; i + 4 * FLOAT_VEC_SIZE <= len; i += 4 * FLOAT_VEC_SIZE) {
+        __float_vector A0 = _float_loadu(in + i);
+        __float_vector A1 = _float_loadu(in + i + FLOAT_VEC_SIZE);
+        __float_vector A2 = _float_loadu(in + i + 2 * FLOAT_VEC_SIZE);
+        __float_vector A3 = _float_loadu(in + i + 3 * FLOAT_VEC_SIZE);
+        S0 = _float_fmadd_vec(A0, A0, S0);
+        S1 = _float_fmadd_vec(A1, A1, S1);
+        S2 = _float_fmadd_vec(A2, A2, S2);
+        S3 = _float_fmadd_vec(A3, A3, S3);
+    }
+    for (; i < len; i += FLOAT_VEC_SIZE) {
+        __float_vector A = _float_maskload(in + i, _float_lane_mask(len - i));
+        S0 = _float_fmadd_vec(A, A, S0);
+    }
+    float ms = _float_hsum_vec(_float_add_vec(_float_add_vec(S0, S1), _float_add_vec(S2, S3))) / len;
+    affine(in, out, len, 0.f, act_rsqrt(ms + eps, mode), gamma, NULL);
+}
+
+/** Elementwise Activations **/
+
+/**
+ * erfc(z) For z >= 0, Relative Error Below 1.2e-7 (Numerical Recipes erfcc)
+ */
+static inline FORCE_INLINE __float_vector erfc_vec(const __float_vector Z) {
+    __float_vector T = _float_div_exact_vec(_float_set1_vec(1.f), _float_fmadd_vec(Z, _float_set1_vec(0.5f), _float_set1_vec(1.f)));
+    __float_vector P = _float_set1_vec(0.17087277f);
+    P = _float_fmadd_vec(P, T, _float_set1_vec(-0.82215223f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(1.48851587f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(-1.13520398f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(0.27886807f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(-0.18628806f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(0.09678418f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(0.37409196f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(1.00002368f));
+    P = _float_fmadd_vec(P, T, _float_set1_vec(-1.26551223f));
+    return _float_mul_vec(T, _float_exp_vec(_float_fmadd_vec(_float_sub_vec(_float_setzero_vec(), Z), Z, P)));
+}
+
+/**
+ * x * Phi(x) = x * (1 - erfc(x / sqrt 2) / 2) For x >= 0, x * erfc(|x| / sqrt 2) / 2 Below
+ */
+static inline FORCE_INLINE __float_vector gelu_erf_vec(const __float_vector X) {
+    __float_vector H = _float_mul_vec(erfc_vec(_float_mul_vec(_float_abs_vec(X, _float_set1_vec(-0.f)), _float_set1_vec(0.70710678f))), _float_set1_vec(0.5f));
+    __float_vector phi = _float_blend_vec(_float_sub_vec(_float_set1_vec(1.f), H), H, _float_lt_vec(X, _float_setzero_vec()));
+    return _float_mul_vec(X, phi);
+}
+
+/**
+ * x * sigmoid(2 sqrt(2 / pi) (x + 0.044715 x^3)), The tanh Form
+ */
+static inline FORCE_INLINE __float_vector gelu_tanh_vec(const __float_vector X) {
+    __float_vector U = _float_mul_vec(X, _float_fmadd_vec(_float_mul_vec(X, X), _float_set1_vec(-0.0713548163f), _float_set1_vec(-1.59576912f)));
+    return _float_mul_vec(X, _float_recp_vec(_float_add_vec(_float_set1_vec(1.f), _float_exp_vec(U))));
+}
+
+static inline FORCE_INLINE __float_vector sigmoid_vec(const __float_vector X) {
+    __float_vector E = _float_exp_vec(_float_sub_vec(_float_setzero_vec(), X));
+    return _float_div_exact_vec(_float_set1_vec(1.f), _float_add_vec(_float_set1_vec(1.f), E));
+}
+
+static inline FORCE_INLINE __float_vector sigmoid_fast_vec(const __float_vector X) {
+    __float_vector E = _float_exp_vec(_float_sub_vec(_float_setzero_vec(), X));
+    return _float_recp_vec(_float_add_vec(_float_set1_vec(1.f), E));
+}
+
+static inline FORCE_INLINE void apply(const float* in, float* out, int len, __float_vector (*op)(const __float_vector)) {
+    int i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, op(_float_loadu(in + i)));
+    }
+    if (i < len) {
+        __int_vector mask = _float_lane_mask(len - i);
+        _float_maskstore(out + i, mask, op(_float_maskload(in + i, mask)));
+    }
+}
+
+void float_gelu(const float* in, float* out, int len, activation_mode mode) {
+    SIMD_PROBE("float_gelu", len);
+    if (mode == ACTIVATION_ACCURATE) {
+        apply(in, out, len, gelu_erf_vec);
+    } else {
+        apply(in, out, len, gelu_tanh_vec);
+    }
+}
+
+void float_sigmoid(const float* in, float* out, int len, activation_mode mode) {
+    SIMD_PROBE("float_sigmoid", len);
+    if (mode == ACTIVATION_ACCURATE) {
+        apply(in, out, len, sigmoid_vec);
+    } else {
+        apply(in, out, len, sigmoid_fast_vec);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Activation And Normalization Kernels
+ *
+ * Each kernel reads its input at most twice and writes it once: statistics
+ * are gathered in one pass (online max/sum for softmax, per lane Welford or
+ * shifted sums for layernorm) and the second pass normalizes. Rows of up to
+ * ACTIVATION_REG_VECS vectors are loaded once and normalized from registers.
+ * Tails use masked loads and stores. out may alias in.
+ *
+ * ACTIVATION_ACCURATE: exact division and square root, erf based GELU,
+ *      Welford statistics; a few ulp from the correctly rounded result, also
+ *      under -ffast-math
+ * ACTIVATION_FAST: _float_recp_vec / _float_rsqrt_vec, a short series for the
+ *      logarithm of log softmax, tanh form GELU and single pass shifted sums;
+ *      with -ffast-math the reciprocals become hardware estimates (about 12
+ *      bits, 14 under AVX512)
+ *
+ * With SIMD_DETERMINISTIC every sum is taken in the canonical order of
+ * simd_reduce.h and the register path is skipped, so results do not depend on
+ * the backend; layernorm then uses two pass statistics in both modes.
+ */
+#define ACTIVATION_REG_VECS 8
+
+typedef enum {
+    ACTIVATION_ACCURATE,
+    ACTIVATION_FAST
+} activation_mode;
+
+/**
+ * Softmax: out[i] = e^(in[i] - max) / sum
+ * @param in
+ * @param out
+ * @param len
+ * @param mode
+ */
+void float_softmax(const float* in, float* out, int len, activation_mode mode);
+
+/**
+ * Log Softmax: out[i] = in[i] - max - log(sum)
+ * @param in
+ * @param out
+ * @param len
+ * @param mode
+ */
+void float_log_softmax(const float* in, float* out, int len, activation_mode mode);
+
+/**
+ * Layer Normalization: out[i] = (in[i] - mean) / sqrt(var + eps) * gamma[i] + beta[i]
+ * @param in
+ * @param out
+ * @param len
+ * @param gamma may be NULL for 1
+ * @param beta may be NULL for 0
+ * @param eps
+ * @param mode
+ */
+void float_layernorm(const float* in, float* out, int len, const float* gamma, const float* beta, float eps, activation_mode mode);
+
+/**
+ * RMS Normalization: out[i] = in[i] / sqrt(mean(in^2) + eps) * gamma[i]
+ * @param in
+ * @param out
+ * @param len
+ * @param gamma may be NULL for 1
+ * @param eps
+ * @param mode
+ */
+void float_rmsnorm(const float* in, float* out, int len, const float* gamma, float eps, activation_mode mode);
+
+/**
+ * GELU: x * Phi(x); ACTIVATION_FAST uses the tanh approximation
+ * @param in
+ * @param out
+ * @param len
+ * @param mode
+ */
+void float_gelu(const float* in, float* out, int len, activation_mode mode);
+
+/**
+ * Logistic Sigmoid: 1 / (1 + e^-x)
+ * @param in
+ * @param out
+ * @param len
+ * @param mode
+ */
+void float_sigmoid(const float* in, float* out, int len, activation_mode mode);
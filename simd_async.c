@@ -0,0 +1,284 @@
+#define _POSIX_C_SOURCE 200809L
+#include "simd_async.h"
+#include "simd_instrument.h"
+#include <stdlib.h>
+#ifndef _WIN32
+    #include <pthread.h>
+    #include <sched.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+#define ASYNC_SPINS 64          // Busy polls before yielding the processor.
+#define ASYNC_YIELDS 256        // Yields before a worker sleeps or a waiter starts napping.
+#define ASYNC_NAP_NS 50000
+
+#ifndef _WIN32
+
+/**
+ * One Ring Slot Per Cache Line
+ *
+ * seq follows the bounded queue protocol of D. Vyukov: a slot is free for
+ * ring position p when seq == p and holds ticket p when seq == p + 1. The
+ * worker sets done to ticket + 1 and only then frees the slot for position
+ * p + SIMD_ASYNC_RING, so done only grows and a future never misses its job.
+ */
+typedef struct {
+    _Alignas(SIMD_CACHE_LINE) uint64_t seq;
+    uint64_t done;
+    const float* in;
+    float* out;
+    int len;
+    float_stream_kernel kernel;
+    void* ctx;
+} async_slot;
+
+struct simd_pool {
+    async_slot ring[SIMD_ASYNC_RING];
+    _Alignas(SIMD_CACHE_LINE) uint64_t head;    // Next position to claim.
+    _Alignas(SIMD_CACHE_LINE) uint64_t tail;    // Next position to submit to.
+    _Alignas(SIMD_CACHE_LINE) int sleepers;
+    bool stopping;
+    pthread_mutex_t idle_lock;                  // Only taken to sleep and to wake a sleeper.
+    pthread_cond_t idle;
+    int workers;
+    pthread_t* threads;
+};
+
+/**
+ * Spin, Then Yield, Then Nap; For Threads Waiting On Other Threads' Progress
+ */
+static void backoff(int* spins) {
+    int n = (*spins)++;
+    if (n < ASYNC_SPINS) {
+        return;
+    }
+    if (n < ASYNC_SPINS + ASYNC_YIELDS) {
+        sched_yield();
+        return;
+    }
+    struct timespec nap = {0, ASYNC_NAP_NS};
+    nanosleep(&nap, NULL);
+}
+
+static bool head_ready(simd_pool* pool) {
+    uint64_t pos = __atomic_load_n(&pool->head, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&pool->ring[pos % SIMD_ASYNC_RING].seq, __ATOMIC_SEQ_CST) == pos + 1;
+}
+
+/**
+ * Claim The Ready Jobs At The Head, Up To A Batch, With One Compare-And-Swap
+ *
+ * Lengths are read before the claim and may belong to a job another worker
+ * takes first; the swap then fails and the scan starts over.
+ * @return number of jobs claimed, starting at *first
+ */
+static int claim(simd_pool* pool, uint64_t* first) {
+    uint64_t pos = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+    while (true) {
+        int n = 0;
+        int64_t bytes = 0;
+        for (; n < SIMD_ASYNC_BATCH; n++) {
+            async_slot* slot = &pool->ring[(pos + n) % SIMD_ASYNC_RING];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + n + 1) {
+                break;
+            }
+            bytes += (int64_t) __atomic_load_n(&slot->len, __ATOMIC_RELAXED) * sizeof(float);
+            if (n > 0 && bytes > SIMD_ASYNC_BATCH_BYTES) {
+                break;
+            }
+        }
+        if (n == 0) {
+            return 0;
+        }
+        if (__atomic_compare_exchange_n(&pool->head, &pos, pos + n, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            *first = pos;
+            return n;
+        }
+    }
+}
+
+/**
+ * Pull Up To A Batch Of A Job's Input Toward The Cache While Another Job Runs
+ */
+static void prefetch_input(const async_slot* slot) {
+    int64_t bytes = min((int64_t) slot->len * (int64_t) sizeof(float), (int64_t) SIMD_ASYNC_BATCH_BYTES);
+    for (int64_t b = 0; b < bytes; b += SIMD_CACHE_LINE) {
+        _simd_prefetch((const char*) slot->in + b, SIMD_PREFETCH_T1);
+    }
+}
+
+static void run_batch(simd_pool* pool, uint64_t first, int n) {
+    for (int j = 0; j < n; j++) {
+        async_slot* slot = &pool->ring[(first + j) % SIMD_ASYNC_RING];
+        if (j + 1 < n) {
+            prefetch_input(&pool->ring[(first + j + 1) % SIMD_ASYNC_RING]);
+        }
+        if ((int64_t) slot->len * (int64_t) sizeof(float) > SIMD_ASYNC_BATCH_BYTES) {
+            float_stream_stage stage = {slot->kernel, slot->ctx};
+            float_stream(slot->in, slot->out, slot->len, &stage, 1);
+        } else if (slot->len > 0) {
+            slot->kernel(slot->in, slot->out, slot->len, slot->ctx);
+        }
+        __atomic_store_n(&slot->done, first + j + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&slot->seq, first + j + SIMD_ASYNC_RING, __ATOMIC_RELEASE);
+    }
+}
+
+static void* worker_main(void* arg) {
+    simd_pool* pool = arg;
+    int idle = 0;
+    while (true) {
+        uint64_t first;
+        int n = claim(pool, &first);
+        if (n > 0) {
+            run_batch(pool, first, n);
+            idle = 0;
+            continue;
+        }
+        if (idle < ASYNC_SPINS + ASYNC_YIELDS) {
+            backoff(&idle);
+            continue;
+        }
+        idle = 0;
+
+        // Announce the sleep before the last look at the ring; simd_submit
+        // publishes before it looks for sleepers, so one of them sees the other.
+        pthread_mutex_lock(&pool->idle_lock);
+        __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        bool stop = false;
+        if (!head_ready(pool)) {
+            if (__atomic_load_n(&pool->stopping, __ATOMIC_SEQ_CST)) {
+                stop = true;
+            } else {
+                pthread_cond_wait(&pool->idle, &pool->idle_lock);
+            }
+        }
+        __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&pool->idle_lock);
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+simd_pool* simd_pool_create(int workers) {
+    if (workers <= 0) {
+        workers = max((int) sysconf(_SC_NPROCESSORS_ONLN), 1);
+    }
+    simd_pool* pool = aligned_alloc(SIMD_CACHE_LINE, sizeof(simd_pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    memset(pool, 0, sizeof(simd_pool));
+    for (uint64_t p = 0; p < SIMD_ASYNC_RING; p++) {
+        pool->ring[p].seq = p;
+    }
+    pool->threads = malloc(workers * sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->idle_lock, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    for (; pool->workers < workers; pool->workers++) {
+        if (pthread_create(&pool->threads[pool->workers], NULL, worker_main, pool) != 0) {
+            break;
+        }
+    }
+    if (pool->workers == 0) {
+        simd_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void simd_pool_destroy(simd_pool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->idle_lock);
+    __atomic_store_n(&pool->stopping, true, __ATOMIC_SEQ_CST);
+    pthread_cond_broadcast(&pool->idle);
+    pthread_mutex_unlock(&pool->idle_lock);
+    for (int w = 0; w < pool->workers; w++) {
+        pthread_join(pool->threads[w], NULL);
+    }
+    pthread_cond_destroy(&pool->idle);
+    pthread_mutex_destroy(&pool->idle_lock);
+    free(pool->threads);
+    free(pool);
+}
+
+simd_future simd_submit(simd_pool* pool, const float* in, float* out, int len, float_stream_kernel kernel, void* ctx) {
+    SIMD_PROBE("simd_submit", len);
+    uint64_t pos = __atomic_load_n(&pool->tail, __ATOMIC_RELAXED);
+    async_slot* slot;
+    int spins = 0;
+    while (true) {
+        slot = &pool->ring[pos % SIMD_ASYNC_RING];
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&pool->tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            continue;
+        }
+        if (seq < pos) {
+            // Full: the slot still holds the job one lap behind.
+            backoff(&spins);
+        }
+        pos = __atomic_load_n(&pool->tail, __ATOMIC_RELAXED);
+    }
+
+    slot->in = in;
+    slot->out = out;
+    __atomic_store_n(&slot->len, len, __ATOMIC_RELAXED);
+    slot->kernel = kernel;
+    slot->ctx = ctx;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool->idle_lock);
+        pthread_cond_signal(&pool->idle);
+        pthread_mutex_unlock(&pool->idle_lock);
+    }
+    simd_future f = {pool, pos};
+    return f;
+}
+
+bool simd_ready(simd_future f) {
+    return __atomic_load_n(&f.pool->ring[f.ticket % SIMD_ASYNC_RING].done, __ATOMIC_ACQUIRE) > f.ticket;
+}
+
+void simd_wait(simd_future f) {
+    int spins = 0;
+    while (!simd_ready(f)) {
+        backoff(&spins);
+    }
+}
+
+#else
+
+simd_pool* simd_pool_create(int workers) {
+    return NULL;
+}
+
+void simd_pool_destroy(simd_pool* pool) {}
+
+simd_future simd_submit(simd_pool* pool, const float* in, float* out, int len, float_stream_kernel kernel, void* ctx) {
+    if (len > 0) {
+        kernel(in, out, len, ctx);
+    }
+    simd_future f = {pool, 0};
+    return f;
+}
+
+bool simd_ready(simd_future f) {
+    return true;
+}
+
+void simd_wait(simd_future f) {}
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+#include "simd_stream.h"
+
+/**
+ * Asynchronous Job Execution
+ *
+ * A pool of worker threads runs float_stream_kernel jobs submitted from any
+ * thread. Jobs wait in a bounded ring of SIMD_ASYNC_RING slots; submitting,
+ * claiming and completing a job are each a few atomic operations, with no
+ * lock. A future is the ticket of its slot, and the slot is not reused until
+ * the job has completed, so waiting is a load of the slot's completion count.
+ *
+ * A worker claims every ready job at the head of the ring, up to
+ * SIMD_ASYNC_BATCH jobs or SIMD_ASYNC_BATCH_BYTES of input, with one
+ * compare-and-swap, and runs them back to back; while one job of a batch
+ * computes, the input of the next is prefetched into L2. A job with more
+ * input than a batch is claimed alone and runs through float_stream, cache
+ * block by cache block. Idle workers spin briefly, then sleep until the next
+ * submission.
+ *
+ * Each job runs whole on one worker, so its result does not depend on the
+ * number of workers or on which worker runs it. Jobs may complete out of
+ * submission order. The pool requires POSIX threads; elsewhere no pool can be
+ * created and simd_submit runs the job before returning.
+ */
+#define SIMD_ASYNC_RING 1024
+#define SIMD_ASYNC_BATCH 32
+#define SIMD_ASYNC_BATCH_BYTES (64*1024)
+
+typedef struct simd_pool simd_pool;
+
+typedef struct {
+    simd_pool* pool;
+    uint64_t ticket;
+} simd_future;
+
+/**
+ * Start A Pool Of workers Threads
+ * @param workers <= 0 for one per online processor
+ * @return NULL on failure
+ */
+simd_pool* simd_pool_create(int workers);
+
+/**
+ * Finish Every Submitted Job, Then Stop And Free The Pool
+ * @param pool
+ */
+void simd_pool_destroy(simd_pool* pool);
+
+/**
+ * Queue kernel(in, out, len, ctx); Waits For A Free Slot If The Ring Is Full
+ *
+ * in, out and ctx must stay valid until the job completes.
+ * @param pool
+ * @param in
+ * @param out may equal in
+ * @param len
+ * @param kernel
+ * @param ctx
+ * @return
+ */
+simd_future simd_submit(simd_pool* pool, const float* in, float* out, int len, float_stream_kernel kernel, void* ctx);
+
+/**
+ * Whether The Job Has Completed, Without Blocking
+ * @param f
+ * @return
+ */
+bool simd_ready(simd_future f);
+
+/**
+ * Block Until The Job Has Completed; Its Output Is Then Visible To The Caller
+ * @param f
+ */
+void simd_wait(simd_future f);
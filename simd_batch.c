@@ -0,0 +1,195 @@
+#include "simd_batch.h"
+#include "simd_instrument.h"
+#include "simd_reduce.h"
+
+#ifndef SIMD_DETERMINISTIC
+static void store_lanes(float* out, const __float_vector A, int n) {
+    float lanes[FLOAT_VEC_SIZE];
+    _float_storeu(lanes, A);
+    memcpy(out, lanes, n * sizeof(float));
+}
+#endif
+
+/**
+ * Each Lane Of The Result Is One Array: Partial Sums Are Accumulated Per
+ * Array, Then Reduced Together By _float_hsum_lanes_vec
+ */
+static void dot_group(const float* const* a, const float* const* b, const int* lens, int n, float* out) {
+#ifdef SIMD_DETERMINISTIC
+    for (int l = 0; l < n; l++) {
+        out[l] = float_dot_canonical(a[l], b[l], lens[l]);
+    }
+#else
+    __float_vector acc[FLOAT_VEC_SIZE];
+    for (int l = 0; l < FLOAT_VEC_SIZE; l++) {
+        acc[l] = _float_setzero_vec();
+        if (l >= n) {
+            continue;
+        }
+        int k = 0;
+        for (; k + FLOAT_VEC_SIZE <= lens[l]; k += FLOAT_VEC_SIZE) {
+            acc[l] = _float_fmadd_vec(_float_loadu(a[l] + k), _float_loadu(b[l] + k), acc[l]);
+        }
+        if (k < lens[l]) {
+            __int_vector mask = _float_lane_mask(lens[l] - k);
+            acc[l] = _float_fmadd_vec(_float_maskload(a[l] + k, mask), _float_maskload(b[l] + k, mask), acc[l]);
+        }
+    }
+    store_lanes(out, _float_hsum_lanes_vec(acc), n);
+#endif
+}
+
+static void norm_group(const float* const* a, const int* lens, int n, float* out) {
+#ifdef SIMD_DETERMINISTIC
+    for (int l = 0; l < n; l++) {
+        out[l] = sqrtf(float_dot_canonical(a[l], a[l], lens[l]));
+    }
+#else
+    __float_vector acc[FLOAT_VEC_SIZE];
+    for (int l = 0; l < FLOAT_VEC_SIZE; l++) {
+        acc[l] = _float_setzero_vec();
+        if (l >= n) {
+            continue;
+        }
+        int k = 0;
+        for (; k + FLOAT_VEC_SIZE <= lens[l]; k += FLOAT_VEC_SIZE) {
+            __float_vector A = _float_loadu(a[l] + k);
+            acc[l] = _float_fmadd_vec(A, A, acc[l]);
+        }
+        if (k < lens[l]) {
+            __float_vector A = _float_maskload(a[l] + k, _float_lane_mask(lens[l] - k));
+            acc[l] = _float_fmadd_vec(A, A, acc[l]);
+        }
+    }
+    store_lanes(out, _float_sqrt_vec(_float_hsum_lanes_vec(acc)), n);
+#endif
+}
+
+/**
+ * Exponentials Are Written Out On The Way, Then Scaled By The Reciprocals Of
+ * All Sums In The Group, Which Come From One Division; out May Alias in
+ */
+static void softmax_group(const float* const* in, float* const* out, const int* lens, int n) {
+    __float_vector ninf = _float_set1_vec(-INFINITY);
+    __float_vector acc[FLOAT_VEC_SIZE];
+    for (int l = 0; l < FLOAT_VEC_SIZE; l++) {
+        acc[l] = _float_setzero_vec();
+        if (l >= n || lens[l] <= 0) {
+            continue;
+        }
+        const float* x = in[l];
+        int k = 0;
+        __float_vector M = ninf;
+        for (; k + FLOAT_VEC_SIZE <= lens[l]; k += FLOAT_VEC_SIZE) {
+            M = _float_max_vec(M, _float_loadu(x + k));
+        }
+        __int_vector mask = _float_lane_mask(lens[l] - k);
+        if (k < lens[l]) {
+            M = _float_max_vec(M, _float_blend_vec(ninf, _float_maskload(x + k, mask), mask));
+        }
+        M = _float_set1_vec(_float_hmax_vec(M));
+
+        for (k = 0; k + FLOAT_VEC_SIZE <= lens[l]; k += FLOAT_VEC_SIZE) {
+            __float_vector E = _float_exp_vec(_float_sub_vec(_float_loadu(x + k), M));
+            _float_storeu(out[l] + k, E);
+            acc[l] = _float_add_vec(acc[l], E);
+        }
+        if (k < lens[l]) {
+            __float_vector E = _float_exp_vec(_float_sub_vec(_float_maskload(x + k, mask), M));
+            E = _float_blend_vec(_float_setzero_vec(), E, mask);
+            _float_maskstore(out[l] + k, mask, E);
+            acc[l] = _float_add_vec(acc[l], E);
+        }
+    }
+
+    float inv[FLOAT_VEC_SIZE];
+#ifdef SIMD_DETERMINISTIC
+    for (int l = 0; l < n; l++) {
+        inv[l] = lens[l] > 0 ? 1.f / float_sum_canonical(out[l], lens[l]) : 0.f;
+    }
+#else
+    _float_storeu(inv, _float_div_vec(_float_set1_vec(1.f), _float_hsum_lanes_vec(acc)));
+#endif
+    for (int l = 0; l < n; l++) {
+        __float_vector S = _float_set1_vec(inv[l]);
+        float* y = out[l];
+        int k = 0;
+        for (; k + FLOAT_VEC_SIZE <= lens[l]; k += FLOAT_VEC_SIZE) {
+            _float_storeu(y + k, _float_mul_vec(_float_loadu(y + k), S));
+        }
+        if (k < lens[l]) {
+            __int_vector mask = _float_lane_mask(lens[l] - k);
+            _float_maskstore(y + k, mask, _float_mul_vec(_float_maskload(y + k, mask), S));
+        }
+    }
+}
+
+/**
+ * Pointers And Lengths Of The Group Starting At Array i In The Strided Layout
+ */
+static int strided_group(const float* a, int64_t stride, const int* lens, int len, int count, int i,
+                         const float** p, int* group_lens) {
+    int n = min(FLOAT_VEC_SIZE, count - i);
+    for (int l = 0; l < n; l++) {
+        p[l] = a + (i + l) * stride;
+        group_lens[l] = lens != NULL ? lens[i + l] : len;
+    }
+    return n;
+}
+
+void float_dot_batch(const float* const* a, const float* const* b, const int* lens, int count, float* out) {
+    SIMD_PROBE("float_dot_batch", count);
+    for (int i = 0; i < count; i += FLOAT_VEC_SIZE) {
+        dot_group(a + i, b + i, lens + i, min(FLOAT_VEC_SIZE, count - i), out + i);
+    }
+}
+
+void float_dot_batch_strided(const float* a, const float* b, int64_t stride, const int* lens, int len, int count, float* out) {
+    SIMD_PROBE("float_dot_batch_strided", count);
+    const float* pa[FLOAT_VEC_SIZE];
+    const float* pb[FLOAT_VEC_SIZE];
+    int group_lens[FLOAT_VEC_SIZE];
+    for (int i = 0; i < count; i += FLOAT_VEC_SIZE) {
+        strided_group(b, stride, lens, len, count, i, pb, group_lens);
+        int n = strided_group(a, stride, lens, len, count, i, pa, group_lens);
+        dot_group(pa, pb, group_lens, n, out + i);
+    }
+}
+
+void float_norm_batch(const float* const* a, const int* lens, int count, float* out) {
+    SIMD_PROBE("float_norm_batch", count);
+    for (int i = 0; i < count; i += FLOAT_VEC_SIZE) {
+        norm_group(a + i, lens + i, min(FLOAT_VEC_SIZE, count - i), out + i);
+    }
+}
+
+void float_norm_batch_strided(const float* a, int64_t stride, const int* lens, int len, int count, float* out) {
+    SIMD_PROBE("float_norm_batch_strided", count);
+    const float* pa[FLOAT_VEC_SIZE];
+    int group_lens[FLOAT_VEC_SIZE];
+    for (int i = 0; i < count; i += FLOAT_VEC_SIZE) {
+        int n = strided_group(a, stride, lens, len, count, i, pa, group_lens);
+        norm_group(pa, group_lens, n, out + i);
+    }
+}
+
+void float_softmax_batch(const float* const* in, float* const* out, const int* lens, int count) {
+    SIMD_PROBE("float_softmax_batch", count);
+    for (int i = 0; i < count; i += FLOAT_VEC_SIZE) {
+        softmax_group(in + i, out + i, lens + i, min(FLOAT_VEC_SIZE, count - i));
+    }
+}
+
+void float_softmax_batch_strided(const float* in, float* out, int64_t stride, const int* lens, int len, int count) {
+    SIMD_PROBE("float_softmax_batch_strided", count);
+    const float* pin[FLOAT_VEC_SIZE];
+    float* pout[FLOAT_VEC_SIZE];
+    int group_lens[FLOAT_VEC_SIZE];
+    for (int i = 0; i < count; i += FLOAT_VEC_SIZE) {
+        int n = strided_group(in, stride, lens, len, count, i, pin, group_lens);
+        for (int l = 0; l < n; l++) {
+            pout[l] = out + (i + l) * stride;
+        }
+        softmax_group(pin, pout, group_lens, n);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Batched Operations On Many Short Arrays
+ *
+ * Each call processes FLOAT_VEC_SIZE arrays at a time, one array per result
+ * lane: every array is accumulated with plain contiguous loads and a masked
+ * tail, and the group is then reduced together by _float_hsum_lanes_vec, so
+ * there is no alignment peeling, no scalar tail and one horizontal step per
+ * group rather than per array. Suited to arrays of a few to a few hundred
+ * elements; long arrays are faster through the per array kernels.
+ *
+ * Arrays are given either as pointer arrays, or as a fixed stride layout where
+ * array i starts at base + i * stride. lens gives each array's length; in the
+ * strided form lens may be NULL, in which case every array has len elements.
+ */
+
+/**
+ * Dot Product Of Each Pair a[i], b[i]
+ * @param a
+ * @param b
+ * @param lens
+ * @param count number of arrays
+ * @param out receives count results
+ */
+void float_dot_batch(const float* const* a, const float* const* b, const int* lens, int count, float* out);
+void float_dot_batch_strided(const float* a, const float* b, int64_t stride, const int* lens, int len, int count, float* out);
+
+/**
+ * Euclidean Norm Of Each Array
+ * @param a
+ * @param lens
+ * @param count
+ * @param out receives count results
+ */
+void float_norm_batch(const float* const* a, const int* lens, int count, float* out);
+void float_norm_batch_strided(const float* a, int64_t stride, const int* lens, int len, int count, float* out);
+
+/**
+ * Softmax Of Each Array; out May Alias in
+ * @param in
+ * @param out arrays laid out like in
+ * @param lens
+ * @param count
+ */
+void float_softmax_batch(const float* const* in, float* const* out, const int* lens, int count);
+void float_softmax_batch_strided(const float* in, float* out, int64_t stride, const int* lens, int len, int count);
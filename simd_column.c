@@ -0,0 +1,353 @@
+#define _POSIX_C_SOURCE 200809L
+#include "simd_column.h"
+#include "simd_instrument.h"
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#define COLUMN_HEADER_BYTES 64
+#define COLUMN_PAD 64
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t ncols;
+    char reserved[COLUMN_HEADER_BYTES - 16];
+} column_header;
+
+static int64_t round_up(int64_t x, int64_t m) {
+    return (x + m - 1) / m * m;
+}
+
+static uint32_t column_elem_size(uint32_t type) {
+    return type == SIMD_COLUMN_FLOAT ? sizeof(float) : type == SIMD_COLUMN_DOUBLE ? sizeof(double) : 0;
+}
+
+/**
+ * Sections Are Never Empty, So Every Column Can Be Mapped
+ */
+static int64_t column_section_bytes(int64_t count, uint32_t elem_size) {
+    return round_up(max(count * elem_size, 1), COLUMN_PAD);
+}
+
+static bool write_zeros(FILE* out, int64_t n) {
+    static const char zeros[SIMD_COLUMN_ALIGN] = {0};
+    while (n > 0) {
+        size_t k = (size_t) min(n, SIMD_COLUMN_ALIGN);
+        if (fwrite(zeros, 1, k, out) != k) {
+            return false;
+        }
+        n -= k;
+    }
+    return true;
+}
+
+bool simd_column_write(const char* path, const simd_column_desc* cols, int ncols) {
+    if (ncols < 0) {
+        return false;
+    }
+    simd_column_info* info = calloc(max(ncols, 1), sizeof(simd_column_info));
+    if (info == NULL) {
+        return false;
+    }
+
+    int64_t offset = round_up(COLUMN_HEADER_BYTES + (int64_t) ncols * sizeof(simd_column_info), SIMD_COLUMN_ALIGN);
+    for (int i = 0; i < ncols; i++) {
+        uint32_t elem_size = column_elem_size(cols[i].type);
+        if (elem_size == 0 || cols[i].count < 0 || strlen(cols[i].name) >= SIMD_COLUMN_NAME_MAX) {
+            free(info);
+            return false;
+        }
+        strcpy(info[i].name, cols[i].name);
+        info[i].type = cols[i].type;
+        info[i].elem_size = elem_size;
+        info[i].count = cols[i].count;
+        info[i].offset = offset;
+        info[i].bytes = column_section_bytes(cols[i].count, elem_size);
+        offset = round_up(offset + info[i].bytes, SIMD_COLUMN_ALIGN);
+    }
+
+    FILE* out = fopen(path, "wb");
+    if (out == NULL) {
+        free(info);
+        return false;
+    }
+    column_header header = {SIMD_COLUMN_MAGIC, SIMD_COLUMN_VERSION, (uint32_t) ncols, {0}};
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              (ncols == 0 || fwrite(info, sizeof(simd_column_info), ncols, out) == (size_t) ncols);
+    int64_t pos = COLUMN_HEADER_BYTES + (int64_t) ncols * sizeof(simd_column_info);
+    for (int i = 0; i < ncols && ok; i++) {
+        int64_t data = cols[i].count * info[i].elem_size;
+        ok = write_zeros(out, info[i].offset - pos) &&
+             (data == 0 || fwrite(cols[i].data, 1, data, out) == (size_t) data) &&
+             write_zeros(out, info[i].bytes - data);
+        pos = info[i].offset + info[i].bytes;
+    }
+    free(info);
+    if (fclose(out) != 0 || !ok) {
+        remove(path);
+        return false;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+struct simd_column_file {
+    int fd;
+    int ncols;
+    simd_column_info* info;
+    void** maps;
+    size_t* map_lens;
+};
+
+/**
+ * Map len Bytes At A SIMD_COLUMN_ALIGN Aligned File Offset; The System Page
+ * May Be Larger, So The Mapping Can Start Before off
+ * @return pointer to the byte at off, or NULL
+ */
+static void* column_map(int fd, int64_t off, int64_t len, void** base, size_t* base_len) {
+    int64_t page = sysconf(_SC_PAGESIZE);
+    int64_t start = off / page * page;
+    *base_len = (size_t) (off - start + len);
+    *base = mmap(NULL, *base_len, PROT_READ, MAP_PRIVATE, fd, (off_t) start);
+    if (*base == MAP_FAILED) {
+        *base = NULL;
+        return NULL;
+    }
+    posix_madvise(*base, *base_len, POSIX_MADV_SEQUENTIAL);
+    return (char*) *base + (off - start);
+}
+
+simd_column_file* simd_column_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    column_header header;
+    if (fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header) ||
+        memcmp(header.magic, SIMD_COLUMN_MAGIC, 8) != 0 || header.version != SIMD_COLUMN_VERSION ||
+        header.ncols > INT32_MAX / sizeof(simd_column_info) ||
+        COLUMN_HEADER_BYTES + (int64_t) header.ncols * (int64_t) sizeof(simd_column_info) > (int64_t) st.st_size) {
+        close(fd);
+        return NULL;
+    }
+
+    int ncols = (int) header.ncols;
+    simd_column_file* f = calloc(1, sizeof(simd_column_file));
+    simd_column_info* info = calloc(max(ncols, 1), sizeof(simd_column_info));
+    void** maps = calloc(max(ncols, 1), sizeof(void*));
+    size_t* map_lens = calloc(max(ncols, 1), sizeof(size_t));
+    ssize_t dir_bytes = (ssize_t) (ncols * sizeof(simd_column_info));
+    bool ok = f != NULL && info != NULL && maps != NULL && map_lens != NULL &&
+              pread(fd, info, dir_bytes, COLUMN_HEADER_BYTES) == dir_bytes;
+
+    for (int i = 0; i < ncols && ok; i++) {
+        simd_column_info* c = &info[i];
+        c->name[SIMD_COLUMN_NAME_MAX - 1] = '\0';
+        ok = c->elem_size != 0 && c->elem_size == column_elem_size(c->type) &&
+             c->count >= 0 && c->count <= INT64_MAX / c->elem_size &&
+             c->offset > 0 && c->offset % SIMD_COLUMN_ALIGN == 0 &&
+             c->bytes == column_section_bytes(c->count, c->elem_size) &&
+             c->offset <= st.st_size - c->bytes;
+    }
+    if (!ok) {
+        free(f);
+        free(info);
+        free(maps);
+        free(map_lens);
+        close(fd);
+        return NULL;
+    }
+
+    f->fd = fd;
+    f->ncols = ncols;
+    f->info = info;
+    f->maps = maps;
+    f->map_lens = map_lens;
+    return f;
+}
+
+void simd_column_close(simd_column_file* f) {
+    if (f == NULL) {
+        return;
+    }
+    for (int i = 0; i < f->ncols; i++) {
+        if (f->maps[i] != NULL) {
+            munmap(f->maps[i], f->map_lens[i]);
+        }
+    }
+    close(f->fd);
+    free(f->info);
+    free(f->maps);
+    free(f->map_lens);
+    free(f);
+}
+
+int simd_column_count(const simd_column_file* f) {
+    return f->ncols;
+}
+
+int simd_column_find(const simd_column_file* f, const char* name) {
+    for (int i = 0; i < f->ncols; i++) {
+        if (strcmp(f->info[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const simd_column_info* simd_column_get_info(const simd_column_file* f, int i) {
+    return i >= 0 && i < f->ncols ? &f->info[i] : NULL;
+}
+
+static const void* column_span(simd_column_file* f, int i, uint32_t type) {
+    if (i < 0 || i >= f->ncols || f->info[i].type != type) {
+        return NULL;
+    }
+    const simd_column_info* c = &f->info[i];
+    SIMD_PROBE("simd_column_span", c->count);
+    if (f->maps[i] == NULL) {
+        return column_map(f->fd, c->offset, c->bytes, &f->maps[i], &f->map_lens[i]);
+    }
+    return (const char*) f->maps[i] + (f->map_lens[i] - c->bytes);
+}
+
+const float* simd_column_floats(simd_column_file* f, int i) {
+    return column_span(f, i, SIMD_COLUMN_FLOAT);
+}
+
+const double* simd_column_doubles(simd_column_file* f, int i) {
+    return column_span(f, i, SIMD_COLUMN_DOUBLE);
+}
+
+/** Streaming **/
+
+bool simd_column_stream_open(simd_column_stream* s, simd_column_file* f, int i, int64_t window_bytes) {
+    if (i < 0 || i >= f->ncols) {
+        return false;
+    }
+    s->file = f;
+    s->column = i;
+    s->window = round_up(max(window_bytes, 1), SIMD_COLUMN_ALIGN);
+    s->next = 0;
+    s->map = NULL;
+    s->map_len = 0;
+#ifdef POSIX_FADV_SEQUENTIAL
+    const simd_column_info* c = &f->info[i];
+    posix_fadvise(f->fd, (off_t) c->offset, (off_t) c->bytes, POSIX_FADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+/**
+ * Unmap The Current Window And Drop Its Clean Pages From The Page Cache,
+ * So A Pass Over A Huge Column Does Not Evict Everything Else
+ */
+static void stream_release(simd_column_stream* s) {
+    if (s->map == NULL) {
+        return;
+    }
+    munmap(s->map, s->map_len);
+#ifdef POSIX_FADV_DONTNEED
+    const simd_column_info* c = &s->file->info[s->column];
+    int64_t done = s->next * c->elem_size;
+    int64_t start = max(done - s->window, 0);
+    posix_fadvise(s->file->fd, (off_t) (c->offset + start), (off_t) (done - start), POSIX_FADV_DONTNEED);
+#endif
+    s->map = NULL;
+    s->map_len = 0;
+}
+
+static int64_t stream_next(simd_column_stream* s, uint32_t type, const void** span) {
+    *span = NULL;
+    const simd_column_info* c = &s->file->info[s->column];
+    if (c->type != type) {
+        return -1;
+    }
+    stream_release(s);
+    if (s->next >= c->count) {
+        return 0;
+    }
+
+    // Windows start on SIMD_COLUMN_ALIGN boundaries and hold whole elements;
+    // the last one runs to the end of the padded section.
+    int64_t start = s->next * c->elem_size;
+    int64_t len = min(s->window, c->bytes - start);
+    int64_t n = min(s->window / c->elem_size, c->count - s->next);
+    SIMD_PROBE("simd_column_stream", n);
+    *span = column_map(s->file->fd, c->offset + start, len, &s->map, &s->map_len);
+    if (*span == NULL) {
+        return -1;
+    }
+    s->next += n;
+#ifdef POSIX_FADV_WILLNEED
+    if (start + len < c->bytes) {
+        posix_fadvise(s->file->fd, (off_t) (c->offset + start + len), (off_t) min(s->window, c->bytes - start - len),
+                      POSIX_FADV_WILLNEED);
+    }
+#endif
+    return n;
+}
+
+int64_t simd_column_stream_floats(simd_column_stream* s, const float** span) {
+    return stream_next(s, SIMD_COLUMN_FLOAT, (const void**) span);
+}
+
+int64_t simd_column_stream_doubles(simd_column_stream* s, const double** span) {
+    return stream_next(s, SIMD_COLUMN_DOUBLE, (const void**) span);
+}
+
+void simd_column_stream_close(simd_column_stream* s) {
+    stream_release(s);
+}
+
+#else
+
+simd_column_file* simd_column_open(const char* path) {
+    return NULL;
+}
+
+void simd_column_close(simd_column_file* f) {}
+
+int simd_column_count(const simd_column_file* f) {
+    return 0;
+}
+
+int simd_column_find(const simd_column_file* f, const char* name) {
+    return -1;
+}
+
+const simd_column_info* simd_column_get_info(const simd_column_file* f, int i) {
+    return NULL;
+}
+
+const float* simd_column_floats(simd_column_file* f, int i) {
+    return NULL;
+}
+
+const double* simd_column_doubles(simd_column_file* f, int i) {
+    return NULL;
+}
+
+bool simd_column_stream_open(simd_column_stream* s, simd_column_file* f, int i, int64_t window_bytes) {
+    return false;
+}
+
+int64_t simd_column_stream_floats(simd_column_stream* s, const float** span) {
+    return -1;
+}
+
+int64_t simd_column_stream_doubles(simd_column_stream* s, const double** span) {
+    return -1;
+}
+
+void simd_column_stream_close(simd_column_stream* s) {}
+
+#endif
@@ -0,0 +1,130 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Column Files
+ *
+ * A column file holds named float or double columns for zero copy reading:
+ *
+ *   header     64 bytes: "SIMDCOL1", uint32 version, uint32 column count
+ *   directory  one 64 byte simd_column_info per column
+ *   data       one section per column, starting on a SIMD_COLUMN_ALIGN boundary
+ *              and zero padded to a multiple of 64 bytes
+ *
+ * Sections are page aligned so each one can be mapped on its own, and the
+ * padding lets a kernel read whole vectors past the last element. Integers are
+ * little endian. The reader maps sections with MADV_SEQUENTIAL and hands out
+ * spans that pass check_float_align / check_double_align, so kernels run on
+ * page cache memory directly. Reading requires POSIX mmap.
+ */
+#define SIMD_COLUMN_MAGIC "SIMDCOL1"
+#define SIMD_COLUMN_VERSION 1
+#define SIMD_COLUMN_NAME_MAX 32
+#define SIMD_COLUMN_ALIGN 4096
+
+typedef enum {
+    SIMD_COLUMN_FLOAT = 1,
+    SIMD_COLUMN_DOUBLE = 2
+} simd_column_type;
+
+typedef struct {
+    char name[SIMD_COLUMN_NAME_MAX];
+    uint32_t type;
+    uint32_t elem_size;
+    int64_t count;
+    int64_t offset;
+    int64_t bytes;
+} simd_column_info;
+
+/**
+ * In Memory Column To Write
+ */
+typedef struct {
+    const char* name;
+    simd_column_type type;
+    const void* data;
+    int64_t count;
+} simd_column_desc;
+
+typedef struct simd_column_file simd_column_file;
+
+/**
+ * Write A Column File
+ * @param path
+ * @param cols
+ * @param ncols
+ * @return false on I/O error or a name longer than SIMD_COLUMN_NAME_MAX - 1
+ */
+bool simd_column_write(const char* path, const simd_column_desc* cols, int ncols);
+
+/**
+ * Open A Column File; Only The Header And Directory Are Read
+ * @param path
+ * @return NULL if the file is missing or malformed
+ */
+simd_column_file* simd_column_open(const char* path);
+
+/**
+ * Unmap Every Span And Close The File
+ * @param f
+ */
+void simd_column_close(simd_column_file* f);
+
+/**
+ * Directory Access
+ * @param f
+ * @param name / i
+ * @return column count, index of name (-1 if absent), or its directory entry
+ */
+int simd_column_count(const simd_column_file* f);
+int simd_column_find(const simd_column_file* f, const char* name);
+const simd_column_info* simd_column_get_info(const simd_column_file* f, int i);
+
+/**
+ * Map A Whole Column And Return Its Aligned Span, Valid Until simd_column_close
+ * @param f
+ * @param i
+ * @return NULL if i is out of range, the type differs or mapping fails
+ */
+const float* simd_column_floats(simd_column_file* f, int i);
+const double* simd_column_doubles(simd_column_file* f, int i);
+
+/**
+ * Streaming Reader For Columns Larger Than Memory
+ *
+ * Maps one window at a time and unmaps it, dropping its pages from the page
+ * cache, before mapping the next; read ahead is requested one window early.
+ */
+typedef struct {
+    simd_column_file* file;
+    int column;
+    int64_t window;
+    int64_t next;
+    void* map;
+    size_t map_len;
+} simd_column_stream;
+
+/**
+ * Start Streaming Column i
+ * @param s
+ * @param f
+ * @param i
+ * @param window_bytes rounded up to a whole number of SIMD_COLUMN_ALIGN pages
+ * @return false if i is out of range
+ */
+bool simd_column_stream_open(simd_column_stream* s, simd_column_file* f, int i, int64_t window_bytes);
+
+/**
+ * Release The Previous Window And Map The Next One
+ * @param s
+ * @param span receives an aligned pointer to the window's first element
+ * @return elements in the window, 0 at the end of the column, -1 on error or type mismatch
+ */
+int64_t simd_column_stream_floats(simd_column_stream* s, const float** span);
+int64_t simd_column_stream_doubles(simd_column_stream* s, const double** span);
+
+/**
+ * Release The Current Window
+ * @param s
+ */
+void simd_column_stream_close(simd_column_stream* s);
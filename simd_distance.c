@@ -0,0 +1,479 @@
+#include "simd_distance.h"
+#include "simd_instrument.h"
+#include "simd_quantize.h"
+#include "simd_reduce.h"
+#include "simd_sort.h"
+#include <stdlib.h>
+
+#define DISTANCE_TILE 4             // Blocks per one-to-N step.
+#define DISTANCE_QUERY_TILE 4       // Queries per many-to-many step, against two blocks.
+#define TOPK_MIN_CANDIDATES 256
+
+static int block_count(const distance_index* index) {
+    return (index->count + FLOAT_VEC_SIZE - 1) / FLOAT_VEC_SIZE;
+}
+
+static inline FORCE_INLINE __float_vector load_row(const void* blocks, int64_t at, const distance_storage storage) {
+    switch (storage) {
+        case DISTANCE_F16:
+            return _float_loadu_f16((const uint16_t*) blocks + at);
+        case DISTANCE_I8:
+            return _int32_to_float_vec(_int32_loadu_i8((const int8_t*) blocks + at));
+        default:
+            return _float_load((const float*) blocks + at);
+    }
+}
+
+static inline FORCE_INLINE __float_vector accumulate(const __float_vector Q, const __float_vector X, const __float_vector acc, const bool l2) {
+    if (l2) {
+        __float_vector D = _float_sub_vec(Q, X);
+        return _float_fmadd_vec(D, D, acc);
+    }
+    return _float_fmadd_vec(Q, X, acc);
+}
+
+bool distance_index_build(distance_index* index, const float* vectors, int count, int dim, distance_storage storage) {
+    SIMD_PROBE("distance_index_build", count);
+    int nblocks = (count + FLOAT_VEC_SIZE - 1) / FLOAT_VEC_SIZE;
+    int64_t elems = (int64_t) nblocks * dim * FLOAT_VEC_SIZE;
+    if (count < 0 || dim <= 0 || elems > INT32_MAX) {
+        return false;
+    }
+    int len = max((int) elems, FLOAT_VEC_SIZE);
+    float* packed = float_malloc(len);
+    float* norms = float_malloc(max(nblocks, 1) * FLOAT_VEC_SIZE);
+    if (packed == NULL || norms == NULL) {
+        free(packed);
+        free(norms);
+        return false;
+    }
+
+    for (int b = 0; b < nblocks; b++) {
+        float* block = packed + (int64_t) b * dim * FLOAT_VEC_SIZE;
+        for (int l = 0; l < FLOAT_VEC_SIZE; l++) {
+            int64_t v = (int64_t) b * FLOAT_VEC_SIZE + l;
+            for (int j = 0; j < dim; j++) {
+                block[j * FLOAT_VEC_SIZE + l] = v < count ? vectors[v * dim + j] : 0.f;
+            }
+        }
+    }
+
+    index->count = count;
+    index->dim = dim;
+    index->storage = storage;
+    index->scale = 1.f;
+    index->blocks = packed;
+    index->norms = norms;
+    if (storage == DISTANCE_F16) {
+        index->blocks = malloc(len * sizeof(uint16_t));
+        if (index->blocks != NULL) {
+            float_quantize_f16(packed, index->blocks, len);
+        }
+        free(packed);
+    } else if (storage == DISTANCE_I8) {
+        float lo, hi;
+        float_minmax(packed, len, &lo, &hi);
+        float scale = max(-lo, hi) / INT8_MAX;
+        index->scale = scale > 0.f && scale <= FLT_MAX ? scale : 1.f;
+        index->blocks = malloc(len);
+        if (index->blocks != NULL) {
+            float_quantize_i8(packed, index->blocks, len, index->scale, 0);
+        }
+        free(packed);
+    }
+    if (index->blocks == NULL) {
+        free(norms);
+        return false;
+    }
+
+    // Norms of the decoded vectors, so cosine similarity sees what the dot product sees.
+    __float_vector S2 = _float_set1_vec(index->scale * index->scale);
+    for (int b = 0; b < nblocks; b++) {
+        int64_t at = (int64_t) b * dim * FLOAT_VEC_SIZE;
+        __float_vector acc = _float_setzero_vec();
+        for (int j = 0; j < dim; j++, at += FLOAT_VEC_SIZE) {
+            __float_vector X = load_row(index->blocks, at, storage);
+            acc = _float_fmadd_vec(X, X, acc);
+        }
+        _float_store(norms + b * FLOAT_VEC_SIZE, _float_mul_vec(acc, S2));
+    }
+    if (nblocks == 0) {
+        _float_store(norms, _float_setzero_vec());
+    }
+    return true;
+}
+
+void distance_index_free(distance_index* index) {
+    free(index->blocks);
+    free(index->norms);
+    index->blocks = NULL;
+    index->norms = NULL;
+}
+
+/**
+ * Squared Norm Of A Query
+ */
+static float query_norm(const float* q, int dim) {
+#ifdef SIMD_DETERMINISTIC
+    return float_dot_canonical(q, q, dim);
+#else
+    __float_vector acc = _float_setzero_vec();
+    int j = 0;
+    for (; j + FLOAT_VEC_SIZE <= dim; j += FLOAT_VEC_SIZE) {
+        __float_vector Q = _float_loadu(q + j);
+        acc = _float_fmadd_vec(Q, Q, acc);
+    }
+    if (j < dim) {
+        __float_vector Q = _float_maskload(q + j, _float_lane_mask(dim - j));
+        acc = _float_fmadd_vec(Q, Q, acc);
+    }
+    return _float_hsum_vec(acc);
+#endif
+}
+
+/**
+ * I8 Rows Are Accumulated In Quantized Units: The Queries Are Divided By The
+ * Scale Once, And Every Result Is Multiplied Back By scale^2, Rather Than
+ * Every Decoded Row Being Scaled
+ * @return queries, or scratch holding the encoded copy; NULL if scratch could not be allocated
+ */
+static const float* encode_queries(const distance_index* index, const float* queries, int nq, float** scratch) {
+    *scratch = NULL;
+    if (index->storage != DISTANCE_I8) {
+        return queries;
+    }
+    int64_t len = (int64_t) nq * index->dim;
+    *scratch = float_malloc(max(len, (int64_t) FLOAT_VEC_SIZE));
+    if (*scratch == NULL) {
+        return NULL;
+    }
+    float inv = 1.f / index->scale;
+    int64_t i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(*scratch + i, _float_mul_vec(_float_loadu(queries + i), _float_set1_vec(inv)));
+    }
+    for (; i < len; i++) {
+        (*scratch)[i] = queries[i] * inv;
+    }
+    return *scratch;
+}
+
+/**
+ * Turn A Raw Accumulation Of Block b Into Distances Or Similarities
+ * @param qq squared norm of the original query, for DISTANCE_COSINE
+ */
+static inline FORCE_INLINE __float_vector finish(const distance_index* index, int b, __float_vector acc, float factor, float qq,
+                                                 distance_metric metric) {
+    acc = _float_mul_vec(acc, _float_set1_vec(factor));
+    if (metric == DISTANCE_COSINE) {
+        __float_vector N = _float_mul_vec(_float_load(index->norms + b * FLOAT_VEC_SIZE), _float_set1_vec(qq));
+        acc = _float_div_vec(acc, _float_sqrt_vec(_float_max_vec(N, _float_set1_vec(FLT_MIN))));
+    }
+    return acc;
+}
+
+static void store_block(const distance_index* index, int b, float* out, const __float_vector D) {
+    int n = min(FLOAT_VEC_SIZE, index->count - b * FLOAT_VEC_SIZE);
+    if (n == FLOAT_VEC_SIZE) {
+        _float_storeu(out + b * FLOAT_VEC_SIZE, D);
+    } else {
+        _float_maskstore(out + b * FLOAT_VEC_SIZE, _float_lane_mask(n), D);
+    }
+}
+
+/** Top-k Selection **/
+
+typedef struct {
+    int k;
+    int cap;
+    int n;
+    float threshold;
+    float sign;             // Candidates are kept as sign * distance, so larger is always nearer.
+    float* keys;
+    int* idx;
+    float* top_keys;
+    int* top_pos;
+} topk_state;
+
+static bool topk_init(topk_state* s, int k, int count, distance_metric metric) {
+    s->k = k;
+    s->cap = min(max(2 * k, TOPK_MIN_CANDIDATES), count) + 2 * FLOAT_VEC_SIZE;
+    s->n = 0;
+    s->threshold = -INFINITY;
+    s->sign = metric == DISTANCE_L2 ? -1.f : 1.f;
+    s->keys = malloc(s->cap * sizeof(float));
+    s->idx = malloc(s->cap * sizeof(int));
+    s->top_keys = malloc(k * sizeof(float));
+    s->top_pos = malloc(k * sizeof(int));
+    return s->keys != NULL && s->idx != NULL && s->top_keys != NULL && s->top_pos != NULL;
+}
+
+static void topk_free(topk_state* s) {
+    free(s->keys);
+    free(s->idx);
+    free(s->top_keys);
+    free(s->top_pos);
+}
+
+/**
+ * Cut The Candidates Back To The k Best, Sorted Nearest First
+ */
+static void topk_shrink(topk_state* s) {
+    int kept = float_topk(s->keys, s->n, s->k, s->top_keys, s->top_pos);
+    for (int i = 0; i < kept; i++) {
+        s->top_pos[i] = s->idx[s->top_pos[i]];
+    }
+    memcpy(s->keys, s->top_keys, kept * sizeof(float));
+    memcpy(s->idx, s->top_pos, kept * sizeof(int));
+    s->n = kept;
+    if (kept == s->k) {
+        s->threshold = s->keys[kept - 1];
+    }
+}
+
+/**
+ * Keep The Lanes Of Block b That Beat The Current k-th Best; Most Blocks Of A
+ * Long Scan Keep None And Cost One Compare
+ */
+static void topk_push(topk_state* s, const distance_index* index, int b, __float_vector D) {
+    int n = min(FLOAT_VEC_SIZE, index->count - b * FLOAT_VEC_SIZE);
+    __float_vector K = _float_mul_vec(D, _float_set1_vec(s->sign));
+    if (n < FLOAT_VEC_SIZE) {
+        K = _float_blend_vec(_float_set1_vec(-INFINITY), K, _float_lane_mask(n));
+    }
+    __int_vector mask = _float_lt_vec(_float_set1_vec(s->threshold), K);
+    int added = _float_compress_storeu(s->keys + s->n, mask, K);
+    if (added == 0) {
+        return;
+    }
+    float lanes[FLOAT_VEC_SIZE];
+    _float_compress_storeu(lanes, mask, _float_loadu(float_lane_index));
+    for (int t = 0; t < added; t++) {
+        s->idx[s->n + t] = b * FLOAT_VEC_SIZE + (int) lanes[t];
+    }
+    s->n += added;
+    if (s->n > s->cap - FLOAT_VEC_SIZE) {
+        topk_shrink(s);
+    }
+}
+
+/** One Query **/
+
+/**
+ * Raw Accumulations Of tile Consecutive Blocks From Block b
+ */
+static inline FORCE_INLINE void query_tile(const distance_index* index, const float* q, int b, __float_vector* acc,
+                                           const int tile, const bool l2, const distance_storage storage) {
+    const int64_t stride = (int64_t) index->dim * FLOAT_VEC_SIZE;
+    int64_t at = b * stride;
+    for (int t = 0; t < tile; t++) {
+        acc[t] = _float_setzero_vec();
+    }
+    for (int j = 0; j < index->dim; j++, at += FLOAT_VEC_SIZE) {
+        __float_vector Q = _float_set1_vec(q[j]);
+        for (int t = 0; t < tile; t++) {
+            acc[t] = accumulate(Q, load_row(index->blocks, at + t * stride, storage), acc[t], l2);
+        }
+    }
+}
+
+/**
+ * Scan Every Block, Storing To out Or, When sel Is Given, Selecting Into It
+ */
+static inline FORCE_INLINE void query_scan(const distance_index* index, const float* q, float qq, distance_metric metric,
+                                           float* out, topk_state* sel, const bool l2, const distance_storage storage) {
+    float factor = index->scale * index->scale;
+    int nblocks = block_count(index);
+    __float_vector acc[DISTANCE_TILE];
+    int b = 0;
+    for (; b < nblocks; b += DISTANCE_TILE) {
+        int tile = min(DISTANCE_TILE, nblocks - b);
+        if (tile == DISTANCE_TILE) {
+            query_tile(index, q, b, acc, DISTANCE_TILE, l2, storage);
+        } else {
+            for (int t = 0; t < tile; t++) {
+                query_tile(index, q, b + t, acc + t, 1, l2, storage);
+            }
+        }
+        for (int t = 0; t < tile; t++) {
+            __float_vector D = finish(index, b + t, acc[t], factor, qq, metric);
+            if (sel != NULL) {
+                topk_push(sel, index, b + t, D);
+            } else {
+                store_block(index, b + t, out, D);
+            }
+        }
+    }
+}
+
+static void query_dispatch(const distance_index* index, const float* q, float qq, distance_metric metric, float* out, topk_state* sel) {
+    bool l2 = metric == DISTANCE_L2;
+    switch (index->storage * 2 + l2) {
+        case 0:
+            query_scan(index, q, qq, metric, out, sel, false, DISTANCE_F32);
+            break;
+        case 1:
+            query_scan(index, q, qq, metric, out, sel, true, DISTANCE_F32);
+            break;
+        case 2:
+            query_scan(index, q, qq, metric, out, sel, false, DISTANCE_F16);
+            break;
+        case 3:
+            query_scan(index, q, qq, metric, out, sel, true, DISTANCE_F16);
+            break;
+        case 4:
+            query_scan(index, q, qq, metric, out, sel, false, DISTANCE_I8);
+            break;
+        default:
+            query_scan(index, q, qq, metric, out, sel, true, DISTANCE_I8);
+            break;
+    }
+}
+
+bool float_distances(const distance_index* index, const float* query, distance_metric metric, float* out) {
+    SIMD_PROBE("float_distances", (int64_t) index->count * index->dim);
+    float* scratch;
+    const float* q = encode_queries(index, query, 1, &scratch);
+    if (q == NULL) {
+        return false;
+    }
+    query_dispatch(index, q, query_norm(query, index->dim), metric, out, NULL);
+    free(scratch);
+    return true;
+}
+
+int float_distance_topk(const distance_index* index, const float* query, distance_metric metric, int k, float* values, int* indices) {
+    SIMD_PROBE("float_distance_topk", (int64_t) index->count * index->dim);
+    k = min(k, index->count);
+    if (k <= 0) {
+        return 0;
+    }
+    topk_state sel;
+    float* scratch = NULL;
+    if (!topk_init(&sel, k, index->count, metric)) {
+        topk_free(&sel);
+        return 0;
+    }
+    const float* q = encode_queries(index, query, 1, &scratch);
+    if (q == NULL) {
+        topk_free(&sel);
+        return 0;
+    }
+    query_dispatch(index, q, query_norm(query, index->dim), metric, NULL, &sel);
+    topk_shrink(&sel);
+
+    for (int i = 0; i < sel.n; i++) {
+        if (values != NULL) {
+            values[i] = sel.keys[i] * sel.sign;
+        }
+        if (indices != NULL) {
+            indices[i] = sel.idx[i];
+        }
+    }
+    int found = sel.n;
+    topk_free(&sel);
+    free(scratch);
+    return found;
+}
+
+/** Many Queries **/
+
+/**
+ * Raw Accumulations Of qt Queries Against bt Consecutive Blocks From Block b;
+ * acc[i * bt + t] Pairs Query i With Block b + t
+ */
+static inline FORCE_INLINE void many_tile(const distance_index* index, const float* q, int b, __float_vector* acc,
+                                          const int qt, const int bt, const bool l2, const distance_storage storage) {
+    const int dim = index->dim;
+    const int64_t stride = (int64_t) dim * FLOAT_VEC_SIZE;
+    int64_t at = b * stride;
+    for (int i = 0; i < qt * bt; i++) {
+        acc[i] = _float_setzero_vec();
+    }
+    for (int j = 0; j < dim; j++, at += FLOAT_VEC_SIZE) {
+        __float_vector X[2];
+        for (int t = 0; t < bt; t++) {
+            X[t] = load_row(index->blocks, at + t * stride, storage);
+        }
+        for (int i = 0; i < qt; i++) {
+            __float_vector Q = _float_set1_vec(q[i * dim + j]);
+            for (int t = 0; t < bt; t++) {
+                acc[i * bt + t] = accumulate(Q, X[t], acc[i * bt + t], l2);
+            }
+        }
+    }
+}
+
+static inline FORCE_INLINE void many_scan(const distance_index* index, const float* q, const float* qq, int nq,
+                                          distance_metric metric, float* out, const bool l2, const distance_storage storage) {
+    float factor = index->scale * index->scale;
+    int nblocks = block_count(index);
+    int dim = index->dim;
+    __float_vector acc[DISTANCE_QUERY_TILE * 2];
+    for (int i = 0; i < nq; i += DISTANCE_QUERY_TILE) {
+        int qt = min(DISTANCE_QUERY_TILE, nq - i);
+        for (int b = 0; b < nblocks; b += 2) {
+            int bt = min(2, nblocks - b);
+            if (qt == DISTANCE_QUERY_TILE && bt == 2) {
+                many_tile(index, q + (int64_t) i * dim, b, acc, DISTANCE_QUERY_TILE, 2, l2, storage);
+            } else {
+                for (int ii = 0; ii < qt; ii++) {
+                    for (int t = 0; t < bt; t++) {
+                        many_tile(index, q + (int64_t) (i + ii) * dim, b + t, acc + ii * bt + t, 1, 1, l2, storage);
+                    }
+                }
+            }
+            for (int ii = 0; ii < qt; ii++) {
+                float* row = out + (int64_t) (i + ii) * index->count;
+                for (int t = 0; t < bt; t++) {
+                    store_block(index, b + t, row, finish(index, b + t, acc[ii * bt + t], factor, qq[i + ii], metric));
+                }
+            }
+        }
+    }
+}
+
+bool float_distances_many(const distance_index* index, const float* queries, int nq, distance_metric metric, float* out) {
+    SIMD_PROBE("float_distances_many", (int64_t) nq * index->count * index->dim);
+    if (nq <= 0) {
+        return true;
+    }
+    float* qq = malloc((int64_t) nq * sizeof(float));
+    if (qq == NULL) {
+        return false;
+    }
+    for (int i = 0; i < nq; i++) {
+        qq[i] = query_norm(queries + (int64_t) i * index->dim, index->dim);
+    }
+    float* scratch;
+    const float* q = encode_queries(index, queries, nq, &scratch);
+    if (q == NULL) {
+        free(qq);
+        return false;
+    }
+
+    bool l2 = metric == DISTANCE_L2;
+    switch (index->storage * 2 + l2) {
+        case 0:
+            many_scan(index, q, qq, nq, metric, out, false, DISTANCE_F32);
+            break;
+        case 1:
+            many_scan(index, q, qq, nq, metric, out, true, DISTANCE_F32);
+            break;
+        case 2:
+            many_scan(index, q, qq, nq, metric, out, false, DISTANCE_F16);
+            break;
+        case 3:
+            many_scan(index, q, qq, nq, metric, out, true, DISTANCE_F16);
+            break;
+        case 4:
+            many_scan(index, q, qq, nq, metric, out, false, DISTANCE_I8);
+            break;
+        default:
+            many_scan(index, q, qq, nq, metric, out, true, DISTANCE_I8);
+            break;
+    }
+    free(qq);
+    free(scratch);
+    return true;
+}
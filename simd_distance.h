@@ -0,0 +1,98 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Distance And Similarity Search
+ *
+ * Database vectors are packed into a blocked layout: each block holds
+ * FLOAT_VEC_SIZE vectors transposed, so row j of a block is component j of all
+ * of them and one vector register accumulates FLOAT_VEC_SIZE distances with
+ * no horizontal step. Query components are broadcast, and the kernels are
+ * register tiled over several blocks (and, many-to-many, several queries) so
+ * each load is reused from registers. The block size follows the backend, so
+ * a packed index is only valid within the build that created it.
+ *
+ * Storage may be compressed: DISTANCE_F16 halves memory traffic with IEEE
+ * half precision, DISTANCE_I8 quarters it with symmetric int8 quantization
+ * (one scale per index). Distances are computed against the decoded values.
+ *
+ * DISTANCE_L2: squared Euclidean distance, smaller is nearer
+ * DISTANCE_INNER_PRODUCT: dot product, larger is nearer
+ * DISTANCE_COSINE: cosine similarity, larger is nearer; 0 against a zero vector
+ */
+
+typedef enum {
+    DISTANCE_L2,
+    DISTANCE_INNER_PRODUCT,
+    DISTANCE_COSINE
+} distance_metric;
+
+typedef enum {
+    DISTANCE_F32,
+    DISTANCE_F16,
+    DISTANCE_I8
+} distance_storage;
+
+typedef struct {
+    int count;
+    int dim;
+    distance_storage storage;
+    float scale;        // DISTANCE_I8: decoded value = q * scale
+    void* blocks;       // ceil(count / FLOAT_VEC_SIZE) blocks of dim * FLOAT_VEC_SIZE elements
+    float* norms;       // squared norm of every decoded vector, zero padded to whole blocks
+} distance_index;
+
+/**
+ * Pack count Row Major Vectors Of dim Floats Into An Index
+ * @param index
+ * @param vectors
+ * @param count
+ * @param dim
+ * @param storage
+ * @return false on allocation failure or if the packed index exceeds INT32_MAX elements
+ */
+bool distance_index_build(distance_index* index, const float* vectors, int count, int dim, distance_storage storage);
+
+/**
+ * Release The Memory Of An Index
+ * @param index
+ */
+void distance_index_free(distance_index* index);
+
+/**
+ * Distance From One Query To Every Indexed Vector
+ * @param index
+ * @param query dim floats
+ * @param metric
+ * @param out receives index->count results
+ * @return false if scratch for an I8 index could not be allocated
+ */
+bool float_distances(const distance_index* index, const float* query, distance_metric metric, float* out);
+
+/**
+ * Distances From nq Queries To Every Indexed Vector
+ * @param index
+ * @param queries nq row major vectors of dim floats
+ * @param nq
+ * @param metric
+ * @param out nq rows of index->count results
+ * @return false if scratch could not be allocated
+ */
+bool float_distances_many(const distance_index* index, const float* queries, int nq, distance_metric metric, float* out);
+
+/**
+ * Find The k Nearest Indexed Vectors To query, Nearest First
+ *
+ * Distances are never materialized: each block is compared against the
+ * current k-th best with one vector compare, survivors are compress-stored
+ * into a small candidate buffer, and the buffer is cut back to k with
+ * float_topk when it fills.
+ * @param index
+ * @param query
+ * @param metric
+ * @param k
+ * @param values may be NULL; distances or similarities as float_distances reports them
+ * @param indices may be NULL
+ * @return number of results written (min(k, count)), 0 if scratch could not be allocated
+ */
+int float_distance_topk(const distance_index* index, const float* query, distance_metric metric, int k, float* values, int* indices);
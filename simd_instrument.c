@@ -0,0 +1,246 @@
+#define _GNU_SOURCE
+#include "simd_instrument.h"
+
+#ifdef SIMD_INSTRUMENT
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #include <x86intrin.h>
+#endif
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <pthread.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+static simd_probe* probes = NULL;
+static bool perf_enabled = false;
+static bool perf_available[SIMD_PERF_COUNT];
+
+static const char* perf_names[SIMD_PERF_COUNT] = {
+    "instructions",
+    "cache_misses",
+    "license_avx2_cycles",
+    "license_avx512_cycles"
+};
+
+static uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+#ifdef __linux__
+/**
+ * Counters Are Opened Per Thread On First Use And Left Running; Probes Read
+ * Deltas. The key's destructor closes them when the thread exits.
+ */
+static __thread bool perf_opened = false;
+static __thread int perf_fds[SIMD_PERF_COUNT];
+static pthread_key_t perf_key;
+static pthread_once_t perf_key_once = PTHREAD_ONCE_INIT;
+
+static void perf_close_thread(void* unused) {
+    (void) unused;
+    for (int i = 0; i < SIMD_PERF_COUNT; i++) {
+        if (perf_fds[i] >= 0) {
+            close(perf_fds[i]);
+            perf_fds[i] = -1;
+        }
+    }
+}
+
+static void perf_key_create() {
+    pthread_key_create(&perf_key, perf_close_thread);
+}
+
+static int perf_open(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * Whether The CPU Has CORE_POWER.LVL1/LVL2_TURBO_LICENSE: Intel Family 6
+ * Skylake Through Sapphire Rapids Cores. Elsewhere The Kernel Accepts The Raw
+ * Config But Counts An Unrelated Event.
+ */
+static bool perf_has_license_events() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const unsigned models[] = {
+        0x4e, 0x5e, 0x55, 0x8e, 0x9e, 0xa5, 0xa6, 0x66,     // Skylake, Cascade/Cooper Lake, Kaby/Coffee/Comet Lake, Cannon Lake
+        0x6a, 0x6c, 0x7d, 0x7e, 0xa7, 0x8c, 0x8d,           // Ice Lake, Rocket Lake, Tiger Lake
+        0x8f, 0xcf                                          // Sapphire and Emerald Rapids
+    };
+    unsigned a, b, c, d;
+    if (!__get_cpuid(0, &a, &b, &c, &d) || b != 0x756e6547 || d != 0x49656e69 || c != 0x6c65746e) {
+        return false;    // Not GenuineIntel.
+    }
+    if (!__get_cpuid(1, &a, &b, &c, &d) || ((a >> 8) & 0xf) != 6) {
+        return false;
+    }
+    unsigned model = ((a >> 4) & 0xf) | ((a >> 12) & 0xf0);
+    for (unsigned i = 0; i < sizeof(models)/sizeof(models[0]); i++) {
+        if (model == models[i]) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+static void perf_open_thread() {
+    perf_fds[SIMD_PERF_INSTRUCTIONS] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    perf_fds[SIMD_PERF_CACHE_MISSES] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    perf_fds[SIMD_PERF_LICENSE_AVX2] = -1;
+    perf_fds[SIMD_PERF_LICENSE_AVX512] = -1;
+    if (perf_has_license_events()) {
+        // CORE_POWER.LVL1_TURBO_LICENSE and LVL2_TURBO_LICENSE (event 0x28, umask 0x18 / 0x20).
+        perf_fds[SIMD_PERF_LICENSE_AVX2] = perf_open(PERF_TYPE_RAW, 0x1828);
+        perf_fds[SIMD_PERF_LICENSE_AVX512] = perf_open(PERF_TYPE_RAW, 0x2028);
+    }
+    for (int i = 0; i < SIMD_PERF_COUNT; i++) {
+        if (perf_fds[i] >= 0) {
+            perf_available[i] = true;
+        }
+    }
+    perf_opened = true;
+    pthread_once(&perf_key_once, perf_key_create);
+    pthread_setspecific(perf_key, perf_fds);
+}
+
+/**
+ * @return false if none of this thread's counters is open
+ */
+static bool perf_read(uint64_t* values) {
+    if (!perf_opened) {
+        perf_open_thread();
+    }
+    bool valid = false;
+    for (int i = 0; i < SIMD_PERF_COUNT; i++) {
+        values[i] = 0;
+        if (perf_fds[i] >= 0) {
+            valid = true;
+            if (read(perf_fds[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t)) {
+                values[i] = 0;
+            }
+        }
+    }
+    return valid;
+}
+#else
+static bool perf_read(uint64_t* values) {
+    (void) values;
+    return false;
+}
+#endif
+
+static void register_probe(simd_probe* probe) {
+    if (__atomic_exchange_n(&probe->registered, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+    simd_probe* head = __atomic_load_n(&probes, __ATOMIC_ACQUIRE);
+    do {
+        probe->next = head;
+    } while (!__atomic_compare_exchange_n(&probes, &head, probe, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+simd_probe_scope simd_probe_begin(simd_probe* probe, int64_t elements) {
+    simd_probe_scope scope;
+    scope.probe = probe;
+    if (!__atomic_load_n(&probe->registered, __ATOMIC_ACQUIRE)) {
+        register_probe(probe);
+    }
+    __atomic_fetch_add(&probe->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&probe->elements, (uint64_t) elements, __ATOMIC_RELAXED);
+    scope.perf_valid = perf_enabled && perf_read(scope.perf);
+    scope.start = read_cycles();
+    return scope;
+}
+
+void simd_probe_end(simd_probe_scope* scope) {
+    uint64_t cycles = read_cycles() - scope->start;
+    simd_probe* probe = scope->probe;
+    __atomic_fetch_add(&probe->cycles, cycles, __ATOMIC_RELAXED);
+
+    uint64_t now[SIMD_PERF_COUNT];
+    if (scope->perf_valid && perf_read(now)) {
+        for (int i = 0; i < SIMD_PERF_COUNT; i++) {
+            __atomic_fetch_add(&probe->perf[i], now[i] - scope->perf[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+bool simd_instrument_perf(bool enable) {
+    uint64_t values[SIMD_PERF_COUNT];
+    perf_enabled = false;
+    if (!enable || !perf_read(values)) {
+        return false;
+    }
+    for (int i = 0; i < SIMD_PERF_COUNT; i++) {
+        perf_enabled = perf_enabled || perf_available[i];
+    }
+    return perf_enabled;
+}
+
+void simd_instrument_reset() {
+    for (simd_probe* p = __atomic_load_n(&probes, __ATOMIC_ACQUIRE); p != NULL; p = p->next) {
+        __atomic_store_n(&p->calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&p->elements, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&p->tail_elements, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&p->cycles, 0, __ATOMIC_RELAXED);
+        for (int i = 0; i < SIMD_PERF_COUNT; i++) {
+            __atomic_store_n(&p->perf[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void simd_instrument_write_json(FILE* f) {
+    fprintf(f, "{\"enabled\": true, \"backend\": \"%s\", \"perf\": %s, \"kernels\": [", SIMD_BACKEND, perf_enabled ? "true" : "false");
+    bool first = true;
+    for (simd_probe* p = __atomic_load_n(&probes, __ATOMIC_ACQUIRE); p != NULL; p = p->next) {
+        fprintf(f, "%s\n  {\"name\": \"%s\", \"backend\": \"%s\", \"calls\": %llu, \"elements\": %llu, "
+                   "\"tail_elements\": %llu, \"cycles\": %llu",
+                first ? "" : ",", p->name, p->backend,
+                (unsigned long long) __atomic_load_n(&p->calls, __ATOMIC_RELAXED),
+                (unsigned long long) __atomic_load_n(&p->elements, __ATOMIC_RELAXED),
+                (unsigned long long) __atomic_load_n(&p->tail_elements, __ATOMIC_RELAXED),
+                (unsigned long long) __atomic_load_n(&p->cycles, __ATOMIC_RELAXED));
+        for (int i = 0; i < SIMD_PERF_COUNT; i++) {
+            if (perf_enabled && perf_available[i]) {
+                fprintf(f, ", \"%s\": %llu", perf_names[i], (unsigned long long) __atomic_load_n(&p->perf[i], __ATOMIC_RELAXED));
+            } else {
+                fprintf(f, ", \"%s\": null", perf_names[i]);
+            }
+        }
+        fprintf(f, "}");
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+}
+
+#else
+
+bool simd_instrument_perf(bool enable) {
+    (void) enable;
+    return false;
+}
+
+void simd_instrument_reset() {
+}
+
+void simd_instrument_write_json(FILE* f) {
+    fprintf(f, "{\"enabled\": false, \"backend\": \"%s\", \"perf\": false, \"kernels\": []}\n", SIMD_BACKEND);
+}
+
+#endif
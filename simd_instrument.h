@@ -0,0 +1,85 @@
+#pragma once
+#include "generic_simd.h"
+#include <stdio.h>
+
+/**
+ * Hot Path Instrumentation
+ *
+ * Compiled out unless SIMD_INSTRUMENT is defined. When enabled, every array
+ * level entry point records its call count, element count, elements left to
+ * the scalar tail and elapsed cycles (TSC on x86). Per kernel statistics are
+ * keyed by name and SIMD_BACKEND; nested entry points count inclusively.
+ *
+ * On Linux, simd_instrument_perf(true) additionally samples hardware counters
+ * through perf_event_open around each call: retired instructions, last level
+ * cache misses and, on Intel cores from Skylake through Sapphire Rapids,
+ * cycles spent under the AVX2 and AVX-512 frequency licenses. Counters the
+ * CPU lacks or the kernel refuses to open are reported as null. Requires GCC
+ * or Clang.
+ */
+
+typedef enum {
+    SIMD_PERF_INSTRUCTIONS,
+    SIMD_PERF_CACHE_MISSES,
+    SIMD_PERF_LICENSE_AVX2,
+    SIMD_PERF_LICENSE_AVX512,
+    SIMD_PERF_COUNT
+} simd_perf_event;
+
+typedef struct simd_probe {
+    const char* name;
+    const char* backend;
+    uint64_t calls;
+    uint64_t elements;
+    uint64_t tail_elements;
+    uint64_t cycles;
+    uint64_t perf[SIMD_PERF_COUNT];
+    int registered;
+    struct simd_probe* next;
+} simd_probe;
+
+typedef struct {
+    simd_probe* probe;
+    uint64_t start;
+    uint64_t perf[SIMD_PERF_COUNT];
+    bool perf_valid;
+} simd_probe_scope;
+
+#ifdef SIMD_INSTRUMENT
+    simd_probe_scope simd_probe_begin(simd_probe* probe, int64_t elements);
+    void simd_probe_end(simd_probe_scope* scope);
+
+    /**
+     * Place At The Top Of An Entry Point; The Scope Closes When The Function Returns
+     */
+    #define SIMD_PROBE(kernel, elements) \
+        static simd_probe _simd_probe = {.name = kernel, .backend = SIMD_BACKEND}; \
+        simd_probe_scope _simd_scope __attribute__((cleanup(simd_probe_end))) = simd_probe_begin(&_simd_probe, elements)
+
+    /**
+     * Record Elements Handled By The Scalar Tail
+     */
+    #define SIMD_PROBE_TAIL(elements) \
+        __atomic_fetch_add(&_simd_probe.tail_elements, (uint64_t) (elements), __ATOMIC_RELAXED)
+#else
+    #define SIMD_PROBE(kernel, elements)
+    #define SIMD_PROBE_TAIL(elements) ((void) (elements))
+#endif
+
+/**
+ * Enable Hardware Counter Sampling (Linux Only)
+ * @param enable
+ * @return true if at least one counter could be opened
+ */
+bool simd_instrument_perf(bool enable);
+
+/**
+ * Zero All Recorded Statistics
+ */
+void simd_instrument_reset();
+
+/**
+ * Write A JSON Snapshot Of All Recorded Statistics
+ * @param f
+ */
+void simd_instrument_write_json(FILE* f);
@@ -0,0 +1,254 @@
+#include "simd_poly.h"
+#include "simd_instrument.h"
+#include <stdlib.h>
+
+#define POLY_BLOCK 8    // Coefficients per Estrin block above POLY_SPECIALIZED_DEGREE.
+
+/**
+ * Estrin's Scheme Over degree + 1 Coefficient Vectors; Spelled Out Per Degree,
+ * As A Level By Level Loop Is Left Rolled With The Partial Sums In Memory
+ */
+static inline FORCE_INLINE __float_vector estrin(const __float_vector* C, const int degree, const __float_vector X) {
+    __float_vector X2 = _float_mul_vec(X, X);
+    __float_vector X4 = _float_mul_vec(X2, X2);
+    switch (degree) {
+        case 0:
+            return C[0];
+        case 1:
+            return _float_fmadd_vec(C[1], X, C[0]);
+        case 2:
+            return _float_fmadd_vec(C[2], X2, _float_fmadd_vec(C[1], X, C[0]));
+        case 3:
+            return _float_fmadd_vec(_float_fmadd_vec(C[3], X, C[2]), X2, _float_fmadd_vec(C[1], X, C[0]));
+        default:
+            break;
+    }
+    __float_vector low = _float_fmadd_vec(_float_fmadd_vec(C[3], X, C[2]), X2, _float_fmadd_vec(C[1], X, C[0]));
+    __float_vector high;
+    switch (degree) {
+        case 4:
+            high = C[4];
+            break;
+        case 5:
+            high = _float_fmadd_vec(C[5], X, C[4]);
+            break;
+        case 6:
+            high = _float_fmadd_vec(C[6], X2, _float_fmadd_vec(C[5], X, C[4]));
+            break;
+        default:
+            high = _float_fmadd_vec(_float_fmadd_vec(C[7], X, C[6]), X2, _float_fmadd_vec(C[5], X, C[4]));
+    }
+    low = _float_fmadd_vec(high, X4, low);
+    if (degree == 8) {
+        low = _float_fmadd_vec(C[8], _float_mul_vec(X4, X4), low);
+    }
+    return low;
+}
+
+/**
+ * degree Is A Constant At Every Call, So The Tree Unrolls And C Stays In Registers
+ */
+static inline FORCE_INLINE void polyval_fixed(const float* coeffs, const int degree, const float* in, float* out, int len) {
+    __float_vector C[POLY_SPECIALIZED_DEGREE + 1];
+    for (int k = 0; k <= degree; k++) {
+        C[k] = _float_set1_vec(coeffs[k]);
+    }
+    int i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, estrin(C, degree, _float_loadu(in + i)));
+    }
+    if (i < len) {
+        __int_vector mask = _float_lane_mask(len - i);
+        _float_maskstore(out + i, mask, estrin(C, degree, _float_maskload(in + i, mask)));
+    }
+}
+
+/**
+ * Degree 7 Blocks From The Top Down, p = B0 + x^8 (B1 + x^8 (B2 + ...)); The
+ * Leftover Top Coefficients Start The Chain With A Short Horner Loop
+ */
+static inline FORCE_INLINE __float_vector polyval_blocked_vec(const float* coeffs, int degree, const __float_vector X) {
+    __float_vector X2 = _float_mul_vec(X, X);
+    __float_vector X8 = _float_mul_vec(_float_mul_vec(X2, X2), _float_mul_vec(X2, X2));
+    int full = (degree + 1) / POLY_BLOCK;
+    int top = full * POLY_BLOCK;
+    __float_vector P[POLY_BLOCK];
+    __float_vector acc;
+    if (top <= degree) {
+        acc = _float_set1_vec(coeffs[degree]);
+        for (int k = degree - 1; k >= top; k--) {
+            acc = _float_fmadd_vec(acc, X, _float_set1_vec(coeffs[k]));
+        }
+    } else {
+        full--;
+        for (int k = 0; k < POLY_BLOCK; k++) {
+            P[k] = _float_set1_vec(coeffs[full * POLY_BLOCK + k]);
+        }
+        acc = estrin(P, POLY_BLOCK - 1, X);
+    }
+    for (int b = full - 1; b >= 0; b--) {
+        for (int k = 0; k < POLY_BLOCK; k++) {
+            P[k] = _float_set1_vec(coeffs[b * POLY_BLOCK + k]);
+        }
+        acc = _float_fmadd_vec(acc, X8, estrin(P, POLY_BLOCK - 1, X));
+    }
+    return acc;
+}
+
+static void polyval_blocked(const float* coeffs, int degree, const float* in, float* out, int len) {
+    int i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, polyval_blocked_vec(coeffs, degree, _float_loadu(in + i)));
+    }
+    if (i < len) {
+        __int_vector mask = _float_lane_mask(len - i);
+        _float_maskstore(out + i, mask, polyval_blocked_vec(coeffs, degree, _float_maskload(in + i, mask)));
+    }
+}
+
+void float_polyval(const float* coeffs, int degree, const float* in, float* out, int len) {
+    SIMD_PROBE("float_polyval", len);
+    switch (degree) {
+        case 0: polyval_fixed(coeffs, 0, in, out, len); break;
+        case 1: polyval_fixed(coeffs, 1, in, out, len); break;
+        case 2: polyval_fixed(coeffs, 2, in, out, len); break;
+        case 3: polyval_fixed(coeffs, 3, in, out, len); break;
+        case 4: polyval_fixed(coeffs, 4, in, out, len); break;
+        case 5: polyval_fixed(coeffs, 5, in, out, len); break;
+        case 6: polyval_fixed(coeffs, 6, in, out, len); break;
+        case 7: polyval_fixed(coeffs, 7, in, out, len); break;
+        case 8: polyval_fixed(coeffs, 8, in, out, len); break;
+        default:
+            if (degree > POLY_SPECIALIZED_DEGREE) {
+                polyval_blocked(coeffs, degree, in, out, len);
+            } else if (len > 0) {
+                memset(out, 0, len * sizeof(float));
+            }
+    }
+}
+
+/** Piecewise **/
+
+/**
+ * Last Segment s In [0, segments) With knots[s] <= X, Or 0
+ *
+ * Power of two steps from the largest below segments, each candidate clamped
+ * to the last segment; knots[min(s, last)] <= x is monotone in s, so clamping
+ * keeps the search exact. Indices are kept in float lanes, exact below 2^24,
+ * so the float blend and min serve and only the gather index is converted.
+ */
+static inline FORCE_INLINE __float_vector find_segment(const float* knots, int segments, int top, const __float_vector X) {
+    __float_vector S = _float_setzero_vec();
+    __float_vector last = _float_set1_vec((float) (segments - 1));
+    for (int step = top; step > 0; step >>= 1) {
+        __float_vector C = _float_min_vec(_float_add_vec(S, _float_set1_vec((float) step)), last);
+        __float_vector K = _float_gather_vec(knots, _float_trunc_int32_vec(C));
+        S = _float_blend_vec(S, C, _float_le_vec(K, X));
+    }
+    return S;
+}
+
+/**
+ * Evaluate One Vector; degree Is A Constant Up To POLY_SPECIALIZED_DEGREE,
+ * Beyond That The Gathered Coefficients Go Through Horner's Rule
+ */
+static inline FORCE_INLINE __float_vector piecewise_vec(const float_piecewise* pw, const int degree, int top, const __float_vector X) {
+    __float_vector S = find_segment(pw->knots, pw->segments, top, X);
+    __int32_vector row = _float_trunc_int32_vec(_float_mul_vec(S, _float_set1_vec((float) (degree + 1))));
+    __float_vector T = _float_sub_vec(X, _float_gather_vec(pw->knots, _float_trunc_int32_vec(S)));
+    if (degree <= POLY_SPECIALIZED_DEGREE) {
+        __float_vector P[POLY_SPECIALIZED_DEGREE + 1];
+        for (int k = 0; k <= degree; k++) {
+            P[k] = _float_gather_vec(pw->coeffs + k, row);
+        }
+        return estrin(P, degree, T);
+    }
+    __float_vector acc = _float_gather_vec(pw->coeffs + degree, row);
+    for (int k = degree - 1; k >= 0; k--) {
+        acc = _float_fmadd_vec(acc, T, _float_gather_vec(pw->coeffs + k, row));
+    }
+    return acc;
+}
+
+static inline FORCE_INLINE void piecewise_fixed(const float_piecewise* pw, const int degree, const float* in, float* out, int len) {
+    int top = 0;
+    for (int step = 1; step < pw->segments; step *= 2) {
+        top = step;
+    }
+    int i = 0;
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, piecewise_vec(pw, degree, top, _float_loadu(in + i)));
+    }
+    if (i < len) {
+        __int_vector mask = _float_lane_mask(len - i);
+        _float_maskstore(out + i, mask, piecewise_vec(pw, degree, top, _float_maskload(in + i, mask)));
+    }
+}
+
+void float_piecewise_eval(const float_piecewise* pw, const float* in, float* out, int len) {
+    SIMD_PROBE("float_piecewise_eval", len);
+    switch (pw->degree) {
+        case 0: piecewise_fixed(pw, 0, in, out, len); break;
+        case 1: piecewise_fixed(pw, 1, in, out, len); break;
+        case 2: piecewise_fixed(pw, 2, in, out, len); break;
+        case 3: piecewise_fixed(pw, 3, in, out, len); break;
+        case 4: piecewise_fixed(pw, 4, in, out, len); break;
+        case 5: piecewise_fixed(pw, 5, in, out, len); break;
+        case 6: piecewise_fixed(pw, 6, in, out, len); break;
+        case 7: piecewise_fixed(pw, 7, in, out, len); break;
+        case 8: piecewise_fixed(pw, 8, in, out, len); break;
+        default:
+            if (pw->degree > POLY_SPECIALIZED_DEGREE) {
+                piecewise_fixed(pw, pw->degree, in, out, len);
+            } else if (len > 0) {
+                memset(out, 0, len * sizeof(float));
+            }
+    }
+}
+
+/**
+ * Second Derivatives From The Tridiagonal System (Thomas Algorithm), Then
+ * Each Segment Expanded Around Its Left Knot
+ */
+bool float_natural_spline(const float* x, const float* y, int n, float* coeffs) {
+    SIMD_PROBE("float_natural_spline", n);
+    if (n < 2) {
+        return false;
+    }
+    for (int i = 0; i + 1 < n; i++) {
+        if (!(x[i] < x[i + 1])) {
+            return false;
+        }
+    }
+    double* m = malloc(2 * n * sizeof(double));
+    if (m == NULL) {
+        return false;
+    }
+    double* c = m + n;
+
+    m[0] = 0.;
+    c[0] = 0.;
+    for (int i = 1; i + 1 < n; i++) {
+        double h0 = (double) x[i] - x[i - 1];
+        double h1 = (double) x[i + 1] - x[i];
+        double r = 6. * (((double) y[i + 1] - y[i]) / h1 - ((double) y[i] - y[i - 1]) / h0);
+        double d = 2. * (h0 + h1) - h0 * c[i - 1];
+        c[i] = h1 / d;
+        m[i] = (r - h0 * m[i - 1]) / d;
+    }
+    m[n - 1] = 0.;
+    for (int i = n - 2; i > 0; i--) {
+        m[i] -= c[i] * m[i + 1];
+    }
+
+    for (int i = 0; i + 1 < n; i++) {
+        double h = (double) x[i + 1] - x[i];
+        float* row = coeffs + 4 * i;
+        row[0] = y[i];
+        row[1] = (float) (((double) y[i + 1] - y[i]) / h - h * (2. * m[i] + m[i + 1]) / 6.);
+        row[2] = (float) (m[i] / 2.);
+        row[3] = (float) ((m[i + 1] - m[i]) / (6. * h));
+    }
+    free(m);
+    return true;
+}
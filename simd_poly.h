@@ -0,0 +1,64 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Polynomial And Piecewise Polynomial Evaluation
+ *
+ * Polynomials are evaluated with Estrin's scheme: coefficient pairs are
+ * combined with x, the pairs with x^2, those with x^4 and so on, a tree of
+ * depth log2(degree + 1) rather than Horner's chain of degree dependent
+ * multiply-adds, so the independent products of one level issue together.
+ * Degrees up to POLY_SPECIALIZED_DEGREE are compiled separately with the tree
+ * unrolled in registers; higher degrees are evaluated as degree 7 blocks
+ * joined by Horner steps in x^8.
+ *
+ * Piecewise polynomials (splines, calibration tables) find the segment of
+ * every lane with a branchless binary search over the breakpoints, one gather
+ * per halving step, then gather the coefficients of that segment and evaluate
+ * in local coordinates x - knots[s]. Inputs outside the breakpoints, and NaN,
+ * extrapolate the first or last segment. AVX without AVX2 has no gather
+ * instruction, so each gather there is a load per lane.
+ *
+ * Coefficients are lowest power first: coeffs[k] multiplies x^k.
+ */
+#define POLY_SPECIALIZED_DEGREE 8
+
+typedef struct {
+    int segments;
+    int degree;
+    const float* knots;     // segments + 1 ascending breakpoints
+    const float* coeffs;    // segments rows of degree + 1 coefficients in powers of x - knots[s]
+} float_piecewise;
+
+/**
+ * Evaluate A Polynomial: out[i] = sum_k coeffs[k] * in[i]^k
+ * @param coeffs degree + 1 coefficients
+ * @param degree negative for the zero polynomial
+ * @param in
+ * @param out may alias in
+ * @param len
+ */
+void float_polyval(const float* coeffs, int degree, const float* in, float* out, int len);
+
+/**
+ * Evaluate A Piecewise Polynomial: out[i] = sum_k coeffs[s * (degree + 1) + k] * (in[i] - knots[s])^k
+ * Where s Is The Last Segment With knots[s] <= in[i], Or 0
+ * @param pw segments >= 1 and segments * (degree + 1) below 2^24; negative degree for zero
+ * @param in
+ * @param out may alias in
+ * @param len
+ */
+void float_piecewise_eval(const float_piecewise* pw, const float* in, float* out, int len);
+
+/**
+ * Natural Cubic Spline Through n Points, In The float_piecewise Layout
+ *
+ * Solved in double precision; use x as the knots of a float_piecewise with
+ * n - 1 segments of degree 3.
+ * @param x n strictly ascending abscissae
+ * @param y n ordinates
+ * @param n >= 2
+ * @param coeffs receives (n - 1) * 4 coefficients
+ * @return false if n < 2, x is not strictly ascending, or on allocation failure
+ */
+bool float_natural_spline(const float* x, const float* y, int n, float* coeffs);
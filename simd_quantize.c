@@ -0,0 +1,272 @@
+#include "simd_quantize.h"
+#include "simd_instrument.h"
+#include "simd_tune.h"
+#include <stdlib.h>
+
+/**
+ * x / scale is clamped to the representable range before rounding, so the
+ * conversion never overflows, then the zero point is added as an integer. The
+ * scalar tail performs the same steps, so every element rounds identically.
+ */
+void float_quantize_u8(const float* in, uint8_t* out, int len, float scale, int zero_point) {
+    SIMD_PROBE("float_quantize_u8", len);
+    float inv = 1.f / scale;
+    float qlo = (float) -zero_point;
+    float qhi = (float) (UINT8_MAX - zero_point);
+    __float_vector I = _float_set1_vec(inv);
+    __float_vector L = _float_set1_vec(qlo);
+    __float_vector H = _float_set1_vec(qhi);
+    __int32_vector Z = _float_to_int32_vec(_float_set1_vec((float) zero_point));
+    int end = float_get_next_index(len, 0);
+    SIMD_PROBE_TAIL(len - end);
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        __float_vector A = _float_mul_vec(_float_loadu(in + i), I);
+        A = _float_min_vec(_float_max_vec(A, L), H);
+        _int32_storeu_u8(out + i, _int32_add_vec(_float_to_int32_vec(A), Z));
+    }
+
+    for (int i = end; i < len; i++) {
+        float a = min(max(in[i] * inv, qlo), qhi);
+        out[i] = (uint8_t) (lrintf(a) + zero_point);
+    }
+}
+
+void float_quantize_i8(const float* in, int8_t* out, int len, float scale, int zero_point) {
+    SIMD_PROBE("float_quantize_i8", len);
+    float inv = 1.f / scale;
+    float qlo = (float) (INT8_MIN - zero_point);
+    float qhi = (float) (INT8_MAX - zero_point);
+    __float_vector I = _float_set1_vec(inv);
+    __float_vector L = _float_set1_vec(qlo);
+    __float_vector H = _float_set1_vec(qhi);
+    __int32_vector Z = _float_to_int32_vec(_float_set1_vec((float) zero_point));
+    int end = float_get_next_index(len, 0);
+    SIMD_PROBE_TAIL(len - end);
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        __float_vector A = _float_mul_vec(_float_loadu(in + i), I);
+        A = _float_min_vec(_float_max_vec(A, L), H);
+        _int32_storeu_i8(out + i, _int32_add_vec(_float_to_int32_vec(A), Z));
+    }
+
+    for (int i = end; i < len; i++) {
+        float a = min(max(in[i] * inv, qlo), qhi);
+        out[i] = (int8_t) (lrintf(a) + zero_point);
+    }
+}
+
+/**
+ * Dequantize [start, end) Of in, unroll Vectors Per Iteration; stream Requires out + start Aligned
+ */
+static inline FORCE_INLINE void dequantize_block(const void* in, float* out, int start, int end, float scale, int zero_point,
+                                                 const bool is_signed, const int unroll, const bool stream) {
+    __float_vector S = _float_set1_vec(scale);
+    __float_vector Z = _float_set1_vec((float) zero_point);
+    int i = start;
+
+    for (; i + unroll*FLOAT_VEC_SIZE <= end; i += unroll*FLOAT_VEC_SIZE) {
+        for (int u = 0; u < unroll; u++) {
+            int j = i + u*FLOAT_VEC_SIZE;
+            __int32_vector Q = is_signed ? _int32_loadu_i8((const int8_t*) in + j) : _int32_loadu_u8((const uint8_t*) in + j);
+            __float_vector A = _float_mul_vec(_float_sub_vec(_int32_to_float_vec(Q), Z), S);
+            if (stream) {
+                _float_store(out + j, A);
+            } else {
+                _float_storeu(out + j, A);
+            }
+        }
+    }
+
+    for (; i < end; i += FLOAT_VEC_SIZE) {
+        __int32_vector Q = is_signed ? _int32_loadu_i8((const int8_t*) in + i) : _int32_loadu_u8((const uint8_t*) in + i);
+        __float_vector A = _float_mul_vec(_float_sub_vec(_int32_to_float_vec(Q), Z), S);
+        if (stream) {
+            _float_store(out + i, A);
+        } else {
+            _float_storeu(out + i, A);
+        }
+    }
+}
+
+/**
+ * @return elements converted outside the vector loop
+ */
+static int float_dequantize(const void* in, float* out, int len, float scale, int zero_point, const bool is_signed) {
+    const simd_tuning* t = simd_tuning_get();
+    bool stream = len * (int64_t) sizeof(float) >= t->stream_threshold;
+    // Non-temporal stores need an aligned destination; peel up to the first aligned element.
+    int start = stream ? (int) min(float_next_aligned_pointer(out), (int64_t) len) : 0;
+    int end = float_get_next_index(len, start);
+
+    for (int i = 0; i < start; i++) {
+        float q = is_signed ? (float) ((const int8_t*) in)[i] : (float) ((const uint8_t*) in)[i];
+        out[i] = (q - (float) zero_point) * scale;
+    }
+
+    switch (t->unroll * 2 + stream) {
+        case 2:
+            dequantize_block(in, out, start, end, scale, zero_point, is_signed, 1, false);
+            break;
+        case 3:
+            dequantize_block(in, out, start, end, scale, zero_point, is_signed, 1, true);
+            break;
+        case 4:
+            dequantize_block(in, out, start, end, scale, zero_point, is_signed, 2, false);
+            break;
+        case 5:
+            dequantize_block(in, out, start, end, scale, zero_point, is_signed, 2, true);
+            break;
+        case 8:
+            dequantize_block(in, out, start, end, scale, zero_point, is_signed, 4, false);
+            break;
+        default:
+            dequantize_block(in, out, start, end, scale, zero_point, is_signed, 4, true);
+            break;
+    }
+    if (stream) {
+        _simd_store_fence();
+    }
+
+    for (int i = end; i < len; i++) {
+        float q = is_signed ? (float) ((const int8_t*) in)[i] : (float) ((const uint8_t*) in)[i];
+        out[i] = (q - (float) zero_point) * scale;
+    }
+    return start + len - end;
+}
+
+void float_dequantize_u8(const uint8_t* in, float* out, int len, float scale, int zero_point) {
+    SIMD_PROBE("float_dequantize_u8", len);
+    int tail = float_dequantize(in, out, len, scale, zero_point, false);
+    SIMD_PROBE_TAIL(tail);
+}
+
+void float_dequantize_i8(const int8_t* in, float* out, int len, float scale, int zero_point) {
+    SIMD_PROBE("float_dequantize_i8", len);
+    int tail = float_dequantize(in, out, len, scale, zero_point, true);
+    SIMD_PROBE_TAIL(tail);
+}
+
+void float_quantize_f16(const float* in, uint16_t* out, int len) {
+    SIMD_PROBE("float_quantize_f16", len);
+    int end = float_get_next_index(len, 0);
+    SIMD_PROBE_TAIL(len - end);
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        _float_storeu_f16(out + i, _float_loadu(in + i));
+    }
+
+    for (int i = end; i < len; i++) {
+        out[i] = float_to_f16(in[i]);
+    }
+}
+
+void float_dequantize_f16(const uint16_t* in, float* out, int len) {
+    SIMD_PROBE("float_dequantize_f16", len);
+    int end = float_get_next_index(len, 0);
+    SIMD_PROBE_TAIL(len - end);
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, _float_loadu_f16(in + i));
+    }
+
+    for (int i = end; i < len; i++) {
+        out[i] = f16_to_float(in[i]);
+    }
+}
+
+void float_histogram(const float* in, int len, int bins, float lo, float hi, uint32_t* counts) {
+    SIMD_PROBE("float_histogram", len);
+    if (bins <= 0) {
+        return;
+    }
+    memset(counts, 0, bins * sizeof(uint32_t));
+    if (!(hi > lo)) {
+        return;
+    }
+
+    // One sub-histogram per lane: lanes never collide on a counter, and runs of
+    // equal bins do not serialize on the same store.
+    uint32_t* sub = calloc((size_t) bins * FLOAT_VEC_SIZE, sizeof(uint32_t));
+    float scale = bins / (hi - lo);
+    if (sub == NULL) {
+        for (int i = 0; i < len; i++) {
+            if (in[i] >= lo && in[i] <= hi) {
+                counts[min((int) ((in[i] - lo) * scale), bins - 1)]++;
+            }
+        }
+        return;
+    }
+    __float_vector LO = _float_set1_vec(lo);
+    __float_vector HI = _float_set1_vec(hi);
+    __float_vector S = _float_set1_vec(scale);
+    __float_vector LAST = _float_set1_vec(bins - 0.5f);
+    __float_vector OUT = _float_set1_vec(-1.f);
+    int32_t idx[FLOAT_VEC_SIZE];
+    int end = float_get_next_index(len, 0);
+    SIMD_PROBE_TAIL(len - end);
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        __float_vector A = _float_loadu(in + i);
+        // LAST goes first so that NaNs propagate and fall outside [0, bins).
+        __float_vector T = _float_min_vec(LAST, _float_mul_vec(_float_sub_vec(A, LO), S));
+        T = _float_blend_vec(T, OUT, _float_lt_vec(A, LO));
+        T = _float_blend_vec(T, OUT, _float_lt_vec(HI, A));
+        _int32_storeu(idx, _float_trunc_int32_vec(T));
+
+        for (int j = 0; j < FLOAT_VEC_SIZE; j++) {
+            if ((uint32_t) idx[j] < (uint32_t) bins) {
+                sub[j*bins + idx[j]]++;
+            }
+        }
+    }
+
+    for (int i = end; i < len; i++) {
+        if (in[i] >= lo && in[i] <= hi) {
+            sub[min((int) ((in[i] - lo) * scale), bins - 1)]++;
+        }
+    }
+
+    for (int j = 0; j < FLOAT_VEC_SIZE; j++) {
+        for (int b = 0; b < bins; b++) {
+            counts[b] += sub[j*bins + b];
+        }
+    }
+    free(sub);
+}
+
+void float_minmax(const float* in, int len, float* min_out, float* max_out) {
+    SIMD_PROBE("float_minmax", len);
+    __float_vector MN0 = _float_set1_vec(in[0]);
+    __float_vector MX0 = MN0;
+    __float_vector MN1 = MN0;
+    __float_vector MX1 = MN0;
+    int i = 0;
+
+    // Two independent accumulator pairs hide the min/max latency.
+    for (; i + 2*FLOAT_VEC_SIZE <= len; i += 2*FLOAT_VEC_SIZE) {
+        __float_vector A = _float_loadu(in + i);
+        __float_vector B = _float_loadu(in + i + FLOAT_VEC_SIZE);
+        MN0 = _float_min_vec(MN0, A);
+        MX0 = _float_max_vec(MX0, A);
+        MN1 = _float_min_vec(MN1, B);
+        MX1 = _float_max_vec(MX1, B);
+    }
+
+    for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+        __float_vector A = _float_loadu(in + i);
+        MN0 = _float_min_vec(MN0, A);
+        MX0 = _float_max_vec(MX0, A);
+    }
+
+    float mn = _float_hmin_vec(_float_min_vec(MN0, MN1));
+    float mx = _float_hmax_vec(_float_max_vec(MX0, MX1));
+    SIMD_PROBE_TAIL(len - i);
+    for (; i < len; i++) {
+        mn = min(mn, in[i]);
+        mx = max(mx, in[i]);
+    }
+
+    *min_out = mn;
+    *max_out = mx;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Affine Quantization: q = clamp(round(x / scale) + zero_point), x = (q - zero_point) * scale
+ *
+ * Rounding is to nearest even. Out of range values saturate.
+ */
+
+/**
+ * Quantize Floats To 8-bit Integers
+ * @param in
+ * @param out
+ * @param len
+ * @param scale
+ * @param zero_point
+ */
+void float_quantize_u8(const float* in, uint8_t* out, int len, float scale, int zero_point);
+void float_quantize_i8(const float* in, int8_t* out, int len, float scale, int zero_point);
+
+/**
+ * Dequantize 8-bit Integers To Floats
+ * @param in
+ * @param out
+ * @param len
+ * @param scale
+ * @param zero_point
+ */
+void float_dequantize_u8(const uint8_t* in, float* out, int len, float scale, int zero_point);
+void float_dequantize_i8(const int8_t* in, float* out, int len, float scale, int zero_point);
+
+/**
+ * Convert Floats To IEEE Half Precision And Back
+ *
+ * Rounding is to nearest even; values beyond the half range become infinities.
+ * @param in
+ * @param out
+ * @param len
+ */
+void float_quantize_f16(const float* in, uint16_t* out, int len);
+void float_dequantize_f16(const uint16_t* in, float* out, int len);
+
+/**
+ * Count Values Into bins Equal Width Buckets Over [lo, hi]
+ *
+ * hi itself falls in the last bucket; values outside the range and NaNs are
+ * not counted.
+ * @param in
+ * @param len
+ * @param bins
+ * @param lo
+ * @param hi
+ * @param counts array of bins entries, overwritten
+ */
+void float_histogram(const float* in, int len, int bins, float lo, float hi, uint32_t* counts);
+
+/**
+ * Find The Minimum And Maximum Of An Array
+ * @param in
+ * @param len must be positive
+ * @param min_out
+ * @param max_out
+ */
+void float_minmax(const float* in, int len, float* min_out, float* max_out);
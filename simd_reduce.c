@@ -0,0 +1,519 @@
+#include "simd_reduce.h"
+#include "simd_instrument.h"
+#include "simd_tune.h"
+
+// The error free transformations below break if a multiply and an add are
+// contracted into one FMA behind our back, which GCC does by default in GNU modes,
+// and -ffast-math reassociation folds their error terms to zero.
+#if defined(__clang__)
+    #pragma float_control(precise, on)
+    #pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+    #pragma GCC optimize ("no-fast-math", "fp-contract=off")
+#endif
+
+/**
+ * Pairwise Recursion Splits On Multiples Of REDUCE_LANES And Stops At Blocks
+ * Of PAIRWISE_BLOCK Elements; Under SIMD_DETERMINISTIC Neither Follows The
+ * Vector Width
+ */
+#ifdef SIMD_DETERMINISTIC
+    #define REDUCE_LANES SIMD_CANON_LANES
+#else
+    #define REDUCE_LANES DOUBLE_VEC_SIZE
+#endif
+#define PAIRWISE_BLOCK (32*REDUCE_LANES)
+
+/**
+ * Error Free Transformations
+ *
+ * two_sum: a + b == s + e exactly (Knuth, branch free so it vectorizes).
+ * two_prod: a * b == p + e exactly, through FMA when available and Dekker's
+ * splitting otherwise.
+ *
+ * These rely on strict IEEE evaluation; -ffast-math folds the error terms away.
+ */
+static inline double two_sum(double a, double b, double* e) {
+    double s = a + b;
+    double z = s - a;
+    *e = (a - (s - z)) + (b - z);
+    return s;
+}
+
+static inline FORCE_INLINE __double_vector two_sum_vec(__double_vector a, __double_vector b, __double_vector* e) {
+    __double_vector s = _double_add_vec(a, b);
+    __double_vector z = _double_sub_vec(s, a);
+    *e = _double_add_vec(_double_sub_vec(a, _double_sub_vec(s, z)), _double_sub_vec(b, z));
+    return s;
+}
+
+static inline FORCE_INLINE __double_vector two_prod_vec(__double_vector a, __double_vector b, __double_vector* e) {
+    __double_vector p = _double_mul_vec(a, b);
+#ifdef SIMD_FMA
+    *e = _double_fmadd_vec(a, b, _double_sub_vec(_double_setzero_vec(), p));
+#else
+    __double_vector split = _double_set1_vec(134217729.);  // 2^27 + 1
+    __double_vector t = _double_mul_vec(split, a);
+    __double_vector ah = _double_sub_vec(t, _double_sub_vec(t, a));
+    __double_vector al = _double_sub_vec(a, ah);
+    t = _double_mul_vec(split, b);
+    __double_vector bh = _double_sub_vec(t, _double_sub_vec(t, b));
+    __double_vector bl = _double_sub_vec(b, bh);
+    *e = _double_sub_vec(_double_mul_vec(ah, bh), p);
+    *e = _double_add_vec(*e, _double_mul_vec(ah, bl));
+    *e = _double_add_vec(*e, _double_mul_vec(al, bh));
+    *e = _double_add_vec(*e, _double_mul_vec(al, bl));
+#endif
+    return p;
+}
+
+/**
+ * Canonical Order Sum And Dot Product
+ *
+ * Element i accumulates into virtual lane i % SIMD_CANON_LANES: whole groups
+ * of SIMD_CANON_LANES elements go through CANON_VECS vectors, the remainder is
+ * added to its lane afterwards, and the lanes are combined by the fixed tree
+ * of _float_canon_fold / _double_canon_fold. Every lane sees the same
+ * operations in the same order at any vector width.
+ */
+static inline FORCE_INLINE double double_sum_canon(const double* arr, int len) {
+    __double_vector S[DOUBLE_CANON_VECS];
+    double lanes[SIMD_CANON_LANES];
+    int i = 0;
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        S[k] = _double_setzero_vec();
+    }
+    for (; i + SIMD_CANON_LANES <= len; i += SIMD_CANON_LANES) {
+        for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+            S[k] = _double_add_vec(S[k], _double_loadu(arr + i + k*DOUBLE_VEC_SIZE));
+        }
+    }
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        _double_storeu(lanes + k*DOUBLE_VEC_SIZE, S[k]);
+    }
+    for (; i < len; i++) {
+        lanes[i % SIMD_CANON_LANES] += arr[i];
+    }
+    return _double_canon_fold(lanes);
+}
+
+static inline FORCE_INLINE double double_dot_canon(const double* a, const double* b, int len) {
+    __double_vector S[DOUBLE_CANON_VECS];
+    double lanes[SIMD_CANON_LANES];
+    int i = 0;
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        S[k] = _double_setzero_vec();
+    }
+    for (; i + SIMD_CANON_LANES <= len; i += SIMD_CANON_LANES) {
+        for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+            S[k] = _double_fmadd_vec(_double_loadu(a + i + k*DOUBLE_VEC_SIZE), _double_loadu(b + i + k*DOUBLE_VEC_SIZE), S[k]);
+        }
+    }
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        _double_storeu(lanes + k*DOUBLE_VEC_SIZE, S[k]);
+    }
+    for (; i < len; i++) {
+        lanes[i % SIMD_CANON_LANES] += a[i] * b[i];
+    }
+    return _double_canon_fold(lanes);
+}
+
+/**
+ * Sum Of (a[i] - center) * (b[i] - center), b == a Gives The Squared Deviation
+ */
+static inline FORCE_INLINE float float_dot_canon(const float* a, const float* b, int len, float center) {
+    __float_vector S[FLOAT_CANON_VECS];
+    __float_vector C = _float_set1_vec(center);
+    float lanes[SIMD_CANON_LANES];
+    int i = 0;
+    for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+        S[k] = _float_setzero_vec();
+    }
+    for (; i + SIMD_CANON_LANES <= len; i += SIMD_CANON_LANES) {
+        for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+            __float_vector A = _float_sub_vec(_float_loadu(a + i + k*FLOAT_VEC_SIZE), C);
+            __float_vector B = _float_sub_vec(_float_loadu(b + i + k*FLOAT_VEC_SIZE), C);
+            S[k] = _float_fmadd_vec(A, B, S[k]);
+        }
+    }
+    for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+        _float_storeu(lanes + k*FLOAT_VEC_SIZE, S[k]);
+    }
+    for (; i < len; i++) {
+        lanes[i % SIMD_CANON_LANES] += (a[i] - center) * (b[i] - center);
+    }
+    return _float_canon_fold(lanes);
+}
+
+double double_sum_canonical(const double* arr, int len) {
+    SIMD_PROBE("double_sum_canonical", len);
+    SIMD_PROBE_TAIL(len % SIMD_CANON_LANES);
+    return double_sum_canon(arr, len);
+}
+
+double double_dot_canonical(const double* a, const double* b, int len) {
+    SIMD_PROBE("double_dot_canonical", len);
+    SIMD_PROBE_TAIL(len % SIMD_CANON_LANES);
+    return double_dot_canon(a, b, len);
+}
+
+float float_sum_canonical(const float* arr, int len) {
+    SIMD_PROBE("float_sum_canonical", len);
+    SIMD_PROBE_TAIL(len % SIMD_CANON_LANES);
+    __float_vector S[FLOAT_CANON_VECS];
+    float lanes[SIMD_CANON_LANES];
+    int i = 0;
+    for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+        S[k] = _float_setzero_vec();
+    }
+    for (; i + SIMD_CANON_LANES <= len; i += SIMD_CANON_LANES) {
+        for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+            S[k] = _float_add_vec(S[k], _float_loadu(arr + i + k*FLOAT_VEC_SIZE));
+        }
+    }
+    for (int k = 0; k < FLOAT_CANON_VECS; k++) {
+        _float_storeu(lanes + k*FLOAT_VEC_SIZE, S[k]);
+    }
+    for (; i < len; i++) {
+        lanes[i % SIMD_CANON_LANES] += arr[i];
+    }
+    return _float_canon_fold(lanes);
+}
+
+float float_dot_canonical(const float* a, const float* b, int len) {
+    SIMD_PROBE("float_dot_canonical", len);
+    SIMD_PROBE_TAIL(len % SIMD_CANON_LANES);
+    return float_dot_canon(a, b, len, 0.f);
+}
+
+float float_sumsq_canonical(const float* arr, int len, float center) {
+    SIMD_PROBE("float_sumsq_canonical", len);
+    SIMD_PROBE_TAIL(len % SIMD_CANON_LANES);
+    return float_dot_canon(arr, arr, len, center);
+}
+
+#ifdef SIMD_DETERMINISTIC
+/**
+ * Compensated Sums In Canonical Order: One two_sum Chain And Correction Per
+ * Virtual Lane, Folded Lane By Lane In Index Order
+ */
+static double double_fold_canon_compensated(const double* s_lanes, const double* c_lanes) {
+    double s = 0.;
+    double c = 0.;
+    double e;
+    for (int j = 0; j < SIMD_CANON_LANES; j++) {
+        s = two_sum(s, s_lanes[j], &e);
+        c += e;
+    }
+    for (int j = 0; j < SIMD_CANON_LANES; j++) {
+        c += c_lanes[j];
+    }
+    return s + c;
+}
+
+static double double_sum_compensated_canon(const double* arr, int len) {
+    __double_vector S[DOUBLE_CANON_VECS];
+    __double_vector C[DOUBLE_CANON_VECS];
+    __double_vector E;
+    double s_lanes[SIMD_CANON_LANES];
+    double c_lanes[SIMD_CANON_LANES];
+    double e;
+    int i = 0;
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        S[k] = _double_setzero_vec();
+        C[k] = _double_setzero_vec();
+    }
+    for (; i + SIMD_CANON_LANES <= len; i += SIMD_CANON_LANES) {
+        for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+            S[k] = two_sum_vec(S[k], _double_loadu(arr + i + k*DOUBLE_VEC_SIZE), &E);
+            C[k] = _double_add_vec(C[k], E);
+        }
+    }
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        _double_storeu(s_lanes + k*DOUBLE_VEC_SIZE, S[k]);
+        _double_storeu(c_lanes + k*DOUBLE_VEC_SIZE, C[k]);
+    }
+    for (; i < len; i++) {
+        int l = i % SIMD_CANON_LANES;
+        s_lanes[l] = two_sum(s_lanes[l], arr[i], &e);
+        c_lanes[l] += e;
+    }
+    return double_fold_canon_compensated(s_lanes, c_lanes);
+}
+
+static double double_dot_compensated_canon(const double* a, const double* b, int len) {
+    __double_vector S[DOUBLE_CANON_VECS];
+    __double_vector C[DOUBLE_CANON_VECS];
+    __double_vector P, EP, ES;
+    double s_lanes[SIMD_CANON_LANES];
+    double c_lanes[SIMD_CANON_LANES];
+    double e;
+    int i = 0;
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        S[k] = _double_setzero_vec();
+        C[k] = _double_setzero_vec();
+    }
+    for (; i + SIMD_CANON_LANES <= len; i += SIMD_CANON_LANES) {
+        for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+            P = two_prod_vec(_double_loadu(a + i + k*DOUBLE_VEC_SIZE), _double_loadu(b + i + k*DOUBLE_VEC_SIZE), &EP);
+            S[k] = two_sum_vec(S[k], P, &ES);
+            C[k] = _double_add_vec(C[k], _double_add_vec(EP, ES));
+        }
+    }
+    for (int k = 0; k < DOUBLE_CANON_VECS; k++) {
+        _double_storeu(s_lanes + k*DOUBLE_VEC_SIZE, S[k]);
+        _double_storeu(c_lanes + k*DOUBLE_VEC_SIZE, C[k]);
+    }
+    for (; i < len; i++) {
+        int l = i % SIMD_CANON_LANES;
+        double p = a[i] * b[i];
+        double ep = fma(a[i], b[i], -p);
+        s_lanes[l] = two_sum(s_lanes[l], p, &e);
+        c_lanes[l] += ep + e;
+    }
+    return double_fold_canon_compensated(s_lanes, c_lanes);
+}
+#endif
+
+/**
+ * Plain Sum And Dot Product With acc Independent Accumulators
+ *
+ * acc is a compile time constant at every call site so the accumulator array
+ * stays in registers; the tuned count is picked by the dispatchers below.
+ */
+static inline FORCE_INLINE double double_sum_acc(const double* arr, int len, const int acc) {
+    __double_vector S[8];
+    int i = 0;
+    for (int k = 0; k < acc; k++) {
+        S[k] = _double_setzero_vec();
+    }
+
+    for (; i + acc*DOUBLE_VEC_SIZE <= len; i += acc*DOUBLE_VEC_SIZE) {
+        for (int k = 0; k < acc; k++) {
+            S[k] = _double_add_vec(S[k], _double_loadu(arr + i + k*DOUBLE_VEC_SIZE));
+        }
+    }
+
+    for (; i + DOUBLE_VEC_SIZE <= len; i += DOUBLE_VEC_SIZE) {
+        S[0] = _double_add_vec(S[0], _double_loadu(arr + i));
+    }
+
+    for (int step = 1; step < acc; step *= 2) {
+        for (int k = 0; k + step < acc; k += 2*step) {
+            S[k] = _double_add_vec(S[k], S[k + step]);
+        }
+    }
+    double s = _double_hsum_vec(S[0]);
+    for (; i < len; i++) {
+        s += arr[i];
+    }
+    return s;
+}
+
+static inline FORCE_INLINE double double_dot_acc(const double* a, const double* b, int len, const int acc) {
+    __double_vector S[8];
+    int i = 0;
+    for (int k = 0; k < acc; k++) {
+        S[k] = _double_setzero_vec();
+    }
+
+    for (; i + acc*DOUBLE_VEC_SIZE <= len; i += acc*DOUBLE_VEC_SIZE) {
+        for (int k = 0; k < acc; k++) {
+            S[k] = _double_fmadd_vec(_double_loadu(a + i + k*DOUBLE_VEC_SIZE), _double_loadu(b + i + k*DOUBLE_VEC_SIZE), S[k]);
+        }
+    }
+
+    for (; i + DOUBLE_VEC_SIZE <= len; i += DOUBLE_VEC_SIZE) {
+        S[0] = _double_fmadd_vec(_double_loadu(a + i), _double_loadu(b + i), S[0]);
+    }
+
+    for (int step = 1; step < acc; step *= 2) {
+        for (int k = 0; k + step < acc; k += 2*step) {
+            S[k] = _double_add_vec(S[k], S[k + step]);
+        }
+    }
+    double s = _double_hsum_vec(S[0]);
+    for (; i < len; i++) {
+        s += a[i] * b[i];
+    }
+    return s;
+}
+
+static double double_sum_fast(const double* arr, int len) {
+#ifdef SIMD_DETERMINISTIC
+    return double_sum_canon(arr, len);
+#else
+    switch (simd_tuning_get()->accumulators) {
+        case 1:
+            return double_sum_acc(arr, len, 1);
+        case 2:
+            return double_sum_acc(arr, len, 2);
+        case 8:
+            return double_sum_acc(arr, len, 8);
+        default:
+            return double_sum_acc(arr, len, 4);
+    }
+#endif
+}
+
+static double double_dot_fast(const double* a, const double* b, int len) {
+#ifdef SIMD_DETERMINISTIC
+    return double_dot_canon(a, b, len);
+#else
+    switch (simd_tuning_get()->accumulators) {
+        case 1:
+            return double_dot_acc(a, b, len, 1);
+        case 2:
+            return double_dot_acc(a, b, len, 2);
+        case 8:
+            return double_dot_acc(a, b, len, 8);
+        default:
+            return double_dot_acc(a, b, len, 4);
+    }
+#endif
+}
+
+static double double_sum_pairwise(const double* arr, int len) {
+    if (len <= PAIRWISE_BLOCK) {
+        return double_sum_fast(arr, len);
+    }
+
+    // Split on a vector boundary so both halves keep full vectors.
+    int half = len/2 - (len/2) % REDUCE_LANES;
+    return double_sum_pairwise(arr, half) + double_sum_pairwise(arr + half, len - half);
+}
+
+static double double_dot_pairwise(const double* a, const double* b, int len) {
+    if (len <= PAIRWISE_BLOCK) {
+        return double_dot_fast(a, b, len);
+    }
+
+    int half = len/2 - (len/2) % REDUCE_LANES;
+    return double_dot_pairwise(a, b, half) + double_dot_pairwise(a + half, b + half, len - half);
+}
+
+#ifndef SIMD_DETERMINISTIC
+/**
+ * Fold Vector Partial Sums S And Corrections C Into One Compensated Scalar Pair
+ */
+static double double_fold_compensated(__double_vector S0, __double_vector S1, __double_vector C, double* c) {
+    double lanes[3*DOUBLE_VEC_SIZE];
+    _double_storeu(lanes, S0);
+    _double_storeu(lanes + DOUBLE_VEC_SIZE, S1);
+    _double_storeu(lanes + 2*DOUBLE_VEC_SIZE, C);
+
+    double s = 0.;
+    double e;
+    *c = 0.;
+    for (int j = 0; j < 2*DOUBLE_VEC_SIZE; j++) {
+        s = two_sum(s, lanes[j], &e);
+        *c += e;
+    }
+    for (int j = 2*DOUBLE_VEC_SIZE; j < 3*DOUBLE_VEC_SIZE; j++) {
+        *c += lanes[j];
+    }
+    return s;
+}
+#endif
+
+double double_sum_compensated(const double* arr, int len) {
+    SIMD_PROBE("double_sum_compensated", len);
+#ifdef SIMD_DETERMINISTIC
+    return double_sum_compensated_canon(arr, len);
+#else
+    __double_vector S0 = _double_setzero_vec();
+    __double_vector S1 = _double_setzero_vec();
+    __double_vector C0 = _double_setzero_vec();
+    __double_vector C1 = _double_setzero_vec();
+    __double_vector E;
+    int i = 0;
+
+    // Two independent chains keep the two_sum dependency off the critical path.
+    for (; i + 2*DOUBLE_VEC_SIZE <= len; i += 2*DOUBLE_VEC_SIZE) {
+        S0 = two_sum_vec(S0, _double_loadu(arr + i), &E);
+        C0 = _double_add_vec(C0, E);
+        S1 = two_sum_vec(S1, _double_loadu(arr + i + DOUBLE_VEC_SIZE), &E);
+        C1 = _double_add_vec(C1, E);
+    }
+
+    for (; i + DOUBLE_VEC_SIZE <= len; i += DOUBLE_VEC_SIZE) {
+        S0 = two_sum_vec(S0, _double_loadu(arr + i), &E);
+        C0 = _double_add_vec(C0, E);
+    }
+
+    double c;
+    double e;
+    double s = double_fold_compensated(S0, S1, _double_add_vec(C0, C1), &c);
+    SIMD_PROBE_TAIL(len - i);
+    for (; i < len; i++) {
+        s = two_sum(s, arr[i], &e);
+        c += e;
+    }
+    return s + c;
+#endif
+}
+
+double double_dot_compensated(const double* a, const double* b, int len) {
+    SIMD_PROBE("double_dot_compensated", len);
+#ifdef SIMD_DETERMINISTIC
+    return double_dot_compensated_canon(a, b, len);
+#else
+    __double_vector S0 = _double_setzero_vec();
+    __double_vector S1 = _double_setzero_vec();
+    __double_vector C0 = _double_setzero_vec();
+    __double_vector C1 = _double_setzero_vec();
+    __double_vector P, EP, ES;
+    int i = 0;
+
+    for (; i + 2*DOUBLE_VEC_SIZE <= len; i += 2*DOUBLE_VEC_SIZE) {
+        P = two_prod_vec(_double_loadu(a + i), _double_loadu(b + i), &EP);
+        S0 = two_sum_vec(S0, P, &ES);
+        C0 = _double_add_vec(C0, _double_add_vec(EP, ES));
+        P = two_prod_vec(_double_loadu(a + i + DOUBLE_VEC_SIZE), _double_loadu(b + i + DOUBLE_VEC_SIZE), &EP);
+        S1 = two_sum_vec(S1, P, &ES);
+        C1 = _double_add_vec(C1, _double_add_vec(EP, ES));
+    }
+
+    for (; i + DOUBLE_VEC_SIZE <= len; i += DOUBLE_VEC_SIZE) {
+        P = two_prod_vec(_double_loadu(a + i), _double_loadu(b + i), &EP);
+        S0 = two_sum_vec(S0, P, &ES);
+        C0 = _double_add_vec(C0, _double_add_vec(EP, ES));
+    }
+
+    double c;
+    double e;
+    double s = double_fold_compensated(S0, S1, _double_add_vec(C0, C1), &c);
+    SIMD_PROBE_TAIL(len - i);
+    for (; i < len; i++) {
+        double p = a[i] * b[i];
+        c += fma(a[i], b[i], -p);
+        s = two_sum(s, p, &e);
+        c += e;
+    }
+    return s + c;
+#endif
+}
+
+double double_sum(const double* arr, int len, accuracy_mode mode) {
+    SIMD_PROBE("double_sum", len);
+    switch (mode) {
+        case ACCURACY_PAIRWISE:
+            return double_sum_pairwise(arr, len);
+        case ACCURACY_COMPENSATED:
+            return double_sum_compensated(arr, len);
+        default:
+            return double_sum_fast(arr, len);
+    }
+}
+
+double double_dot(const double* a, const double* b, int len, accuracy_mode mode) {
+    SIMD_PROBE("double_dot", len);
+    switch (mode) {
+        case ACCURACY_PAIRWISE:
+            return double_dot_pairwise(a, b, len);
+        case ACCURACY_COMPENSATED:
+            return double_dot_compensated(a, b, len);
+        default:
+            return double_dot_fast(a, b, len);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Accuracy Modes For Array Reductions
+ * ACCURACY_FAST: plain vector accumulation, error grows O(n)
+ * ACCURACY_PAIRWISE: pairwise blocks, error grows O(log n)
+ * ACCURACY_COMPENSATED: Kahan-Babuska-Neumaier / Ogita-Rump-Oishi, as if
+ *      accumulated in twice the working precision
+ */
+typedef enum {
+    ACCURACY_FAST,
+    ACCURACY_PAIRWISE,
+    ACCURACY_COMPENSATED
+} accuracy_mode;
+
+/**
+ * Sum Of An Array
+ * @param arr
+ * @param len
+ * @param mode
+ * @return
+ */
+double double_sum(const double* arr, int len, accuracy_mode mode);
+
+/**
+ * Dot Product Of Two Arrays
+ * @param a
+ * @param b
+ * @param len
+ * @param mode
+ * @return
+ */
+double double_dot(const double* a, const double* b, int len, accuracy_mode mode);
+
+/**
+ * Compensated Sum And Dot Product, Same As mode == ACCURACY_COMPENSATED
+ *
+ * simd_reduce.c is compiled without fast-math reassociation and contraction
+ * whatever the build flags, so the compensation survives -ffast-math.
+ * @param arr
+ * @param len
+ * @return
+ */
+double double_sum_compensated(const double* arr, int len);
+double double_dot_compensated(const double* a, const double* b, int len);
+
+/**
+ * Canonical Order Reductions
+ *
+ * Summation order fixed by SIMD_CANON_LANES virtual lanes rather than the
+ * vector width; with SIMD_DETERMINISTIC defined the results are bit identical
+ * on every backend, and every reduction in the library goes through them.
+ * float_sumsq_canonical returns the sum of (arr[i] - center)^2.
+ * @param arr / a, b
+ * @param len
+ * @return
+ */
+double double_sum_canonical(const double* arr, int len);
+double double_dot_canonical(const double* a, const double* b, int len);
+float float_sum_canonical(const float* arr, int len);
+float float_dot_canonical(const float* a, const float* b, int len);
+float float_sumsq_canonical(const float* arr, int len, float center);
@@ -0,0 +1,534 @@
+#include "simd_sort.h"
+#include "simd_instrument.h"
+#include <stdlib.h>
+
+/**
+ * Partitions Of At Most SORT_SMALL Elements Are Finished Without Recursing
+ */
+#define SORT_SMALL 16
+#define FLOAT_SORT_NETWORK (2*FLOAT_VEC_SIZE)
+#define DOUBLE_SORT_NETWORK (2*DOUBLE_VEC_SIZE)
+
+static float float_median3(float a, float b, float c) {
+    return max(min(a, b), min(max(a, b), c));
+}
+
+static double double_median3(double a, double b, double c) {
+    return max(min(a, b), min(max(a, b), c));
+}
+
+/**
+ * Move NaNs To The End Of The Array
+ * @return number of leading non-NaN elements
+ */
+static int float_move_nans(float* arr, int len) {
+    int j = 0;
+    for (int i = 0; i < len; i++) {
+        if (!isnan(arr[i])) {
+            float t = arr[j];
+            arr[j++] = arr[i];
+            arr[i] = t;
+        }
+    }
+    return j;
+}
+
+static int double_move_nans(double* arr, int len) {
+    int j = 0;
+    for (int i = 0; i < len; i++) {
+        if (!isnan(arr[i])) {
+            double t = arr[j];
+            arr[j++] = arr[i];
+            arr[i] = t;
+        }
+    }
+    return j;
+}
+
+static int float_move_nan_pairs(float* keys, float* vals, int len) {
+    int j = 0;
+    for (int i = 0; i < len; i++) {
+        if (!isnan(keys[i])) {
+            float t = keys[j];
+            keys[j] = keys[i];
+            keys[i] = t;
+            t = vals[j];
+            vals[j++] = vals[i];
+            vals[i] = t;
+        }
+    }
+    return j;
+}
+
+/**
+ * Sort Up To Two Vectors Worth Of Elements With The Bitonic Network
+ */
+static void float_sort_network(float* arr, int len) {
+    float buf[FLOAT_SORT_NETWORK];
+    for (int i = 0; i < FLOAT_SORT_NETWORK; i++) {
+        buf[i] = i < len ? arr[i] : INFINITY;
+    }
+
+    __float_vector A = _float_sort_vec(_float_loadu(buf));
+    __float_vector B = _float_reverse_vec(_float_sort_vec(_float_loadu(buf + FLOAT_VEC_SIZE)));
+    _float_storeu(buf, _float_bitonic_merge_vec(_float_min_vec(A, B)));
+    _float_storeu(buf + FLOAT_VEC_SIZE, _float_bitonic_merge_vec(_float_max_vec(A, B)));
+    memcpy(arr, buf, len * sizeof(float));
+}
+
+static void double_sort_network(double* arr, int len) {
+    double buf[DOUBLE_SORT_NETWORK];
+    for (int i = 0; i < DOUBLE_SORT_NETWORK; i++) {
+        buf[i] = i < len ? arr[i] : INFINITY;
+    }
+
+    __double_vector A = _double_sort_vec(_double_loadu(buf));
+    __double_vector B = _double_reverse_vec(_double_sort_vec(_double_loadu(buf + DOUBLE_VEC_SIZE)));
+    _double_storeu(buf, _double_bitonic_merge_vec(_double_min_vec(A, B)));
+    _double_storeu(buf + DOUBLE_VEC_SIZE, _double_bitonic_merge_vec(_double_max_vec(A, B)));
+    memcpy(arr, buf, len * sizeof(double));
+}
+
+static void float_sort_small(float* arr, int len) {
+    if (FLOAT_VEC_SIZE > 1 && len <= FLOAT_SORT_NETWORK) {
+        float_sort_network(arr, len);
+        return;
+    }
+
+    for (int i = 1; i < len; i++) {
+        float x = arr[i];
+        int j = i;
+        for (; j > 0 && arr[j-1] > x; j--) {
+            arr[j] = arr[j-1];
+        }
+        arr[j] = x;
+    }
+}
+
+static void double_sort_small(double* arr, int len) {
+    if (DOUBLE_VEC_SIZE > 1 && len <= DOUBLE_SORT_NETWORK) {
+        double_sort_network(arr, len);
+        return;
+    }
+
+    for (int i = 1; i < len; i++) {
+        double x = arr[i];
+        int j = i;
+        for (; j > 0 && arr[j-1] > x; j--) {
+            arr[j] = arr[j-1];
+        }
+        arr[j] = x;
+    }
+}
+
+static void float_sort_small_pairs(float* keys, float* vals, int len) {
+    for (int i = 1; i < len; i++) {
+        float x = keys[i];
+        float v = vals[i];
+        int j = i;
+        for (; j > 0 && keys[j-1] > x; j--) {
+            keys[j] = keys[j-1];
+            vals[j] = vals[j-1];
+        }
+        keys[j] = x;
+        vals[j] = v;
+    }
+}
+
+/**
+ * Partition Around pivot Through tmp
+ *
+ * Elements below the pivot (or equal to it, if inclusive) are compress-stored
+ * from the front of tmp, the rest from the back, then tmp is copied back.
+ * @return size of the lower part
+ */
+static int float_partition(float* arr, float* tmp, int len, float pivot, bool inclusive) {
+    __float_vector P = _float_set1_vec(pivot);
+    int end = float_get_next_index(len, 0);
+    int lo = 0;
+    int hi = len;
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        __float_vector A = _float_loadu(arr + i);
+        __int_vector below = inclusive ? _float_le_vec(A, P) : _float_lt_vec(A, P);
+        __int_vector above = inclusive ? _float_lt_vec(P, A) : _float_le_vec(P, A);
+        int n = _float_compress_storeu(tmp + lo, below, A);
+        lo += n;
+        hi -= FLOAT_VEC_SIZE - n;
+        _float_compress_storeu(tmp + hi, above, A);
+    }
+
+    for (int i = end; i < len; i++) {
+        if (inclusive ? arr[i] <= pivot : arr[i] < pivot) {
+            tmp[lo++] = arr[i];
+        } else {
+            tmp[--hi] = arr[i];
+        }
+    }
+
+    memcpy(arr, tmp, len * sizeof(float));
+    return lo;
+}
+
+static int double_partition(double* arr, double* tmp, int len, double pivot, bool inclusive) {
+    __double_vector P = _double_set1_vec(pivot);
+    int end = double_get_next_index(len, 0);
+    int lo = 0;
+    int hi = len;
+
+    for (int i = 0; i < end; i += DOUBLE_VEC_SIZE) {
+        __double_vector A = _double_loadu(arr + i);
+        __int_vector below = inclusive ? _double_le_vec(A, P) : _double_lt_vec(A, P);
+        __int_vector above = inclusive ? _double_lt_vec(P, A) : _double_le_vec(P, A);
+        int n = _double_compress_storeu(tmp + lo, below, A);
+        lo += n;
+        hi -= DOUBLE_VEC_SIZE - n;
+        _double_compress_storeu(tmp + hi, above, A);
+    }
+
+    for (int i = end; i < len; i++) {
+        if (inclusive ? arr[i] <= pivot : arr[i] < pivot) {
+            tmp[lo++] = arr[i];
+        } else {
+            tmp[--hi] = arr[i];
+        }
+    }
+
+    memcpy(arr, tmp, len * sizeof(double));
+    return lo;
+}
+
+/**
+ * Same As float_partition, But vals (Raw 32-bit Payloads) Follow Their Keys
+ */
+static int float_partition_pairs(float* keys, float* vals, float* tmpk, float* tmpv, int len, float pivot, bool inclusive) {
+    __float_vector P = _float_set1_vec(pivot);
+    int end = float_get_next_index(len, 0);
+    int lo = 0;
+    int hi = len;
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        __float_vector A = _float_loadu(keys + i);
+        __float_vector V = _float_loadu(vals + i);
+        __int_vector below = inclusive ? _float_le_vec(A, P) : _float_lt_vec(A, P);
+        __int_vector above = inclusive ? _float_lt_vec(P, A) : _float_le_vec(P, A);
+        _float_compress_storeu(tmpv + lo, below, V);
+        int n = _float_compress_storeu(tmpk + lo, below, A);
+        lo += n;
+        hi -= FLOAT_VEC_SIZE - n;
+        _float_compress_storeu(tmpk + hi, above, A);
+        _float_compress_storeu(tmpv + hi, above, V);
+    }
+
+    for (int i = end; i < len; i++) {
+        int j = (inclusive ? keys[i] <= pivot : keys[i] < pivot) ? lo++ : --hi;
+        tmpk[j] = keys[i];
+        tmpv[j] = vals[i];
+    }
+
+    memcpy(keys, tmpk, len * sizeof(float));
+    memcpy(vals, tmpv, len * sizeof(float));
+    return lo;
+}
+
+static void float_quicksort(float* arr, float* tmp, int len) {
+    while (len > max(SORT_SMALL, FLOAT_SORT_NETWORK)) {
+        float pivot = float_median3(arr[0], arr[len/2], arr[len-1]);
+        int mid = float_partition(arr, tmp, len, pivot, false);
+
+        if (mid == 0) {
+            // Nothing is below the pivot, so split off the run equal to it.
+            mid = float_partition(arr, tmp, len, pivot, true);
+            arr += mid;
+            len -= mid;
+            continue;
+        }
+
+        // Recurse into the smaller side to bound the stack depth.
+        if (mid < len - mid) {
+            float_quicksort(arr, tmp, mid);
+            arr += mid;
+            len -= mid;
+        } else {
+            float_quicksort(arr + mid, tmp, len - mid);
+            len = mid;
+        }
+    }
+
+    float_sort_small(arr, len);
+}
+
+static void double_quicksort(double* arr, double* tmp, int len) {
+    while (len > max(SORT_SMALL, DOUBLE_SORT_NETWORK)) {
+        double pivot = double_median3(arr[0], arr[len/2], arr[len-1]);
+        int mid = double_partition(arr, tmp, len, pivot, false);
+
+        if (mid == 0) {
+            mid = double_partition(arr, tmp, len, pivot, true);
+            arr += mid;
+            len -= mid;
+            continue;
+        }
+
+        if (mid < len - mid) {
+            double_quicksort(arr, tmp, mid);
+            arr += mid;
+            len -= mid;
+        } else {
+            double_quicksort(arr + mid, tmp, len - mid);
+            len = mid;
+        }
+    }
+
+    double_sort_small(arr, len);
+}
+
+static void float_quicksort_pairs(float* keys, float* vals, float* tmpk, float* tmpv, int len) {
+    while (len > SORT_SMALL) {
+        float pivot = float_median3(keys[0], keys[len/2], keys[len-1]);
+        int mid = float_partition_pairs(keys, vals, tmpk, tmpv, len, pivot, false);
+
+        if (mid == 0) {
+            mid = float_partition_pairs(keys, vals, tmpk, tmpv, len, pivot, true);
+            keys += mid;
+            vals += mid;
+            len -= mid;
+            continue;
+        }
+
+        if (mid < len - mid) {
+            float_quicksort_pairs(keys, vals, tmpk, tmpv, mid);
+            keys += mid;
+            vals += mid;
+            len -= mid;
+        } else {
+            float_quicksort_pairs(keys + mid, vals + mid, tmpk, tmpv, len - mid);
+            len = mid;
+        }
+    }
+
+    float_sort_small_pairs(keys, vals, len);
+}
+
+/**
+ * Reorder So That The First k Pairs Hold The k Smallest Keys, In No Particular Order
+ */
+static void float_select_pairs(float* keys, float* vals, float* tmpk, float* tmpv, int len, int k) {
+    while (len > SORT_SMALL) {
+        float pivot = float_median3(keys[0], keys[len/2], keys[len-1]);
+        int mid = float_partition_pairs(keys, vals, tmpk, tmpv, len, pivot, false);
+
+        if (mid == 0) {
+            // The run equal to the pivot is already in place.
+            mid = float_partition_pairs(keys, vals, tmpk, tmpv, len, pivot, true);
+            if (k <= mid) {
+                return;
+            }
+            keys += mid;
+            vals += mid;
+            len -= mid;
+            k -= mid;
+            continue;
+        }
+
+        if (k < mid) {
+            len = mid;
+        } else if (k == mid) {
+            return;
+        } else {
+            keys += mid;
+            vals += mid;
+            len -= mid;
+            k -= mid;
+        }
+    }
+
+    float_sort_small_pairs(keys, vals, len);
+}
+
+/**
+ * Fallbacks When Scratch Cannot Be Allocated: qsort For Plain Sorts, A Heap Of
+ * Indices For argsort And topk; All NaN Free Or Ordering NaN Last
+ */
+static int float_compare(const void* a, const void* b) {
+    float x = *(const float*) a;
+    float y = *(const float*) b;
+    return (x > y) - (x < y);
+}
+
+static int double_compare(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Whether sign * arr[a] Sorts Before sign * arr[b], NaN Last
+ */
+static inline bool rank_less(const float* arr, float sign, int a, int b) {
+    float x = sign * arr[a];
+    float y = sign * arr[b];
+    return x < y || (isnan(y) && !isnan(x));
+}
+
+/**
+ * Max Heap Of Indices Under rank_less
+ */
+static void heap_sift(const float* arr, float sign, int* heap, int len, int i) {
+    while (true) {
+        int top = i;
+        int l = 2 * i + 1;
+        if (l < len && rank_less(arr, sign, heap[top], heap[l])) {
+            top = l;
+        }
+        if (l + 1 < len && rank_less(arr, sign, heap[top], heap[l + 1])) {
+            top = l + 1;
+        }
+        if (top == i) {
+            return;
+        }
+        int t = heap[i];
+        heap[i] = heap[top];
+        heap[top] = t;
+        i = top;
+    }
+}
+
+/**
+ * Keep The k First Indices Under rank_less In heap, Then Sort Them
+ */
+static void heap_select(const float* arr, float sign, int* heap, int len, int k) {
+    for (int i = 0; i < k; i++) {
+        heap[i] = i;
+    }
+    for (int i = k / 2 - 1; i >= 0; i--) {
+        heap_sift(arr, sign, heap, k, i);
+    }
+    for (int i = k; i < len; i++) {
+        if (rank_less(arr, sign, i, heap[0])) {
+            heap[0] = i;
+            heap_sift(arr, sign, heap, k, 0);
+        }
+    }
+    for (int n = k - 1; n > 0; n--) {
+        int t = heap[0];
+        heap[0] = heap[n];
+        heap[n] = t;
+        heap_sift(arr, sign, heap, n, 0);
+    }
+}
+
+void float_sort(float* arr, int len) {
+    SIMD_PROBE("float_sort", len);
+    len = float_move_nans(arr, len);
+    if (len <= max(SORT_SMALL, FLOAT_SORT_NETWORK)) {
+        float_sort_small(arr, len);
+        return;
+    }
+
+    float* tmp = float_malloc(len);
+    if (tmp == NULL) {
+        qsort(arr, len, sizeof(float), float_compare);
+        return;
+    }
+    float_quicksort(arr, tmp, len);
+    free(tmp);
+}
+
+void double_sort(double* arr, int len) {
+    SIMD_PROBE("double_sort", len);
+    len = double_move_nans(arr, len);
+    if (len <= max(SORT_SMALL, DOUBLE_SORT_NETWORK)) {
+        double_sort_small(arr, len);
+        return;
+    }
+
+    double* tmp = double_malloc(len);
+    if (tmp == NULL) {
+        qsort(arr, len, sizeof(double), double_compare);
+        return;
+    }
+    double_quicksort(arr, tmp, len);
+    free(tmp);
+}
+
+void float_argsort(const float* arr, int* indices, int len) {
+    SIMD_PROBE("float_argsort", len);
+    if (len <= 0) {
+        return;
+    }
+
+    // Indices ride along in float lanes as raw bit patterns; they are only ever moved, never compared.
+    float* work = float_malloc(4 * (int64_t) len);
+    if (work == NULL) {
+        heap_select(arr, 1.f, indices, len, len);
+        return;
+    }
+    float* keys = work;
+    float* vals = work + len;
+
+    memcpy(keys, arr, len * sizeof(float));
+    for (int i = 0; i < len; i++) {
+        indices[i] = i;
+    }
+    memcpy(vals, indices, len * sizeof(int));
+
+    int valid = float_move_nan_pairs(keys, vals, len);
+    float_quicksort_pairs(keys, vals, work + 2*len, work + 3*len, valid);
+
+    memcpy(indices, vals, len * sizeof(int));
+    free(work);
+}
+
+int float_topk(const float* arr, int len, int k, float* values, int* indices) {
+    SIMD_PROBE("float_topk", len);
+    k = min(k, len);
+    if (k <= 0) {
+        return 0;
+    }
+
+    // Select the k smallest of the negated keys, which are the k largest of arr.
+    float* work = float_malloc(4 * (int64_t) len);
+    if (work == NULL) {
+        int* heap = indices != NULL ? indices : malloc(k * sizeof(int));
+        if (heap == NULL) {
+            return 0;
+        }
+        heap_select(arr, -1.f, heap, len, k);
+        if (values != NULL) {
+            for (int i = 0; i < k; i++) {
+                values[i] = arr[heap[i]];
+            }
+        }
+        if (heap != indices) {
+            free(heap);
+        }
+        return k;
+    }
+    float* keys = work;
+    float* vals = work + len;
+    int* idx = (int*) (work + 2*len);
+
+    for (int i = 0; i < len; i++) {
+        keys[i] = -arr[i];
+        idx[i] = i;
+    }
+    memcpy(vals, idx, len * sizeof(int));
+
+    int valid = float_move_nan_pairs(keys, vals, len);
+    int kk = min(k, valid);
+    float_select_pairs(keys, vals, work + 2*len, work + 3*len, valid, kk);
+    float_quicksort_pairs(keys, vals, work + 2*len, work + 3*len, kk);
+
+    if (values != NULL) {
+        for (int i = 0; i < k; i++) {
+            values[i] = -keys[i];
+        }
+    }
+    if (indices != NULL) {
+        memcpy(indices, vals, k * sizeof(int));
+    }
+
+    free(work);
+    return k;
+}
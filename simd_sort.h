@@ -0,0 +1,37 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Vectorized Sorting
+ *
+ * Quicksort with a compress-store partition; partitions of up to two vectors
+ * are finished with the in-register bitonic network (_float_sort_vec).
+ * NaN keys are moved to the end of the array.
+ */
+
+/**
+ * Sort Array In Place, Ascending
+ * @param arr
+ * @param len
+ */
+void float_sort(float* arr, int len);
+void double_sort(double* arr, int len);
+
+/**
+ * Write The Permutation That Sorts arr Ascending, arr Is Left Untouched
+ * @param arr
+ * @param indices
+ * @param len
+ */
+void float_argsort(const float* arr, int* indices, int len);
+
+/**
+ * Find The k Largest Elements, Written In Descending Order
+ * @param arr
+ * @param len
+ * @param k
+ * @param values may be NULL
+ * @param indices may be NULL
+ * @return number of elements written (min(k, len)), or 0 if out of memory
+ */
+int float_topk(const float* arr, int len, int k, float* values, int* indices);
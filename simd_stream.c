@@ -0,0 +1,80 @@
+#include "simd_stream.h"
+#include "simd_instrument.h"
+#include "simd_tune.h"
+#include <stdlib.h>
+
+#define STREAM_CHUNK_BYTES (4*1024)
+
+/**
+ * Overrides; Negative Means Use The Active Tuning
+ */
+static int prefetch_distance = -1;
+static int stream_block = -1;
+
+int simd_prefetch_distance() {
+    return prefetch_distance >= 0 ? prefetch_distance : simd_tuning_get()->prefetch_distance;
+}
+
+void simd_set_prefetch_distance(int bytes) {
+    prefetch_distance = bytes;
+}
+
+void simd_set_stream_block(int bytes) {
+    stream_block = max(bytes, 0);
+}
+
+/**
+ * Block Length In Elements, A Whole Number Of Chunks So Chunks Stay Vector Aligned
+ */
+static int stream_block_len() {
+    int bytes = stream_block > 0 ? stream_block : simd_tuning_get()->stream_block;
+    int chunk = STREAM_CHUNK_BYTES / sizeof(float);
+    return max(bytes / (int) sizeof(float) / chunk, 1) * chunk;
+}
+
+/**
+ * Run The First Stage Chunk By Chunk, Prefetching distance Bytes Ahead Of Each Chunk
+ * @param remaining elements readable from in, including those past this block
+ */
+static void stream_first_stage(const float_stream_stage* stage, const float* in, float* out, int len, int remaining, int distance) {
+    int chunk = STREAM_CHUNK_BYTES / sizeof(float);
+    int64_t limit = (int64_t) remaining * sizeof(float);
+
+    for (int i = 0; i < len; i += chunk) {
+        int n = min(chunk, len - i);
+        if (distance > 0) {
+            int64_t from = (int64_t) i * sizeof(float) + distance;
+            int64_t to = min(from + n * (int64_t) sizeof(float), limit);
+            for (int64_t b = from; b < to; b += SIMD_CACHE_LINE) {
+                _simd_prefetch((const char*) in + b, SIMD_PREFETCH_T0);
+            }
+        }
+        stage->kernel(in + i, out + i, n, stage->ctx);
+    }
+}
+
+void float_stream(const float* in, float* out, int len, const float_stream_stage* stages, int nstages) {
+    SIMD_PROBE("float_stream", len);
+    if (nstages <= 0 || len <= 0) {
+        return;
+    }
+
+    int distance = simd_prefetch_distance();
+    int block = stream_block_len();
+    float* scratch = nstages > 1 ? float_malloc(block) : NULL;
+
+    // Without scratch every stage writes the block of out, the later ones in place.
+    for (int start = 0; start < len; start += block) {
+        int n = min(block, len - start);
+        float* dst = scratch != NULL ? scratch : out + start;
+
+        stream_first_stage(&stages[0], in + start, dst, n, len - start, distance);
+        for (int s = 1; s < nstages; s++) {
+            float* next = s == nstages - 1 || scratch == NULL ? out + start : scratch;
+            stages[s].kernel(dst, next, n, stages[s].ctx);
+            dst = next;
+        }
+    }
+
+    free(scratch);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Tiled Streaming Executor
+ *
+ * Runs a pipeline of kernels over a large array one cache sized block at a
+ * time. The first stage reads from memory with software prefetches issued a
+ * tuned distance ahead; later stages run on the block while it is still
+ * cache resident, and only the last stage writes to out.
+ */
+
+/**
+ * A Kernel Maps len Elements From in To out; It Must Accept in == out
+ */
+typedef void (*float_stream_kernel)(const float* in, float* out, int len, void* ctx);
+
+typedef struct {
+    float_stream_kernel kernel;
+    void* ctx;
+} float_stream_stage;
+
+/**
+ * Run stages In Order Over in, Writing The Result To out
+ * @param in
+ * @param out may equal in
+ * @param len
+ * @param stages
+ * @param nstages
+ */
+void float_stream(const float* in, float* out, int len, const float_stream_stage* stages, int nstages);
+
+/**
+ * Prefetch Distance In Bytes, From The Active Tuning Unless Overridden
+ * @return
+ */
+int simd_prefetch_distance();
+
+/**
+ * Override The Prefetch Distance (0 Disables Prefetching) Or The Block Size;
+ * A Negative Distance Or Zero Block Returns To The Active Tuning
+ * @param bytes
+ */
+void simd_set_prefetch_distance(int bytes);
+void simd_set_stream_block(int bytes);
@@ -0,0 +1,315 @@
+#include "simd_text.h"
+#include "simd_instrument.h"
+#include <stdlib.h>
+
+/**
+ * Bytes Scanned Per Mask; One Bit Per Byte Fills A uint64_t
+ */
+#define SCAN_BLOCK 64
+#define PARSE_INLINE_FIELD 64
+
+/**
+ * Broadcast Character Set For One Scan
+ */
+typedef struct {
+    __u8_vector chars[SIMD_FIND_MAX];
+    int n;
+} scan_set;
+
+static void scan_set_init(scan_set* set, const char* chars) {
+    set->n = 0;
+    while (chars[set->n] != '\0' && set->n < SIMD_FIND_MAX) {
+        set->chars[set->n] = _u8_set1_vec((uint8_t) chars[set->n]);
+        set->n++;
+    }
+}
+
+/**
+ * Bit i Set When s[i] Is In set, For The 64 Bytes Starting At s
+ */
+static inline FORCE_INLINE uint64_t scan_block(const char* s, const scan_set* set) {
+    uint64_t bits = 0;
+    for (int k = 0; k < SCAN_BLOCK; k += U8_VEC_SIZE) {
+        __u8_vector A = _u8_loadu((const uint8_t*) s + k);
+        __u8_mask M = _u8_eq_vec(A, set->chars[0]);
+        for (int j = 1; j < set->n; j++) {
+            M = _u8_or_mask(M, _u8_eq_vec(A, set->chars[j]));
+        }
+        bits |= _u8_movemask(M) << k;
+    }
+    return bits;
+}
+
+/**
+ * Scalar Counterpart Of scan_block For The Tail
+ */
+static uint64_t scan_tail(const char* s, int64_t len, const char* chars) {
+    uint64_t bits = 0;
+    for (int64_t i = 0; i < len; i++) {
+        if (s[i] != '\0' ? strchr(chars, s[i]) != NULL : false) {
+            bits |= 1ull << i;
+        }
+    }
+    return bits;
+}
+
+const char* simd_memchr(const char* s, char c, int64_t len) {
+    SIMD_PROBE("simd_memchr", len);
+    scan_set set;
+    set.chars[0] = _u8_set1_vec((uint8_t) c);
+    set.n = 1;
+    int64_t i = 0;
+
+    for (; i + SCAN_BLOCK <= len; i += SCAN_BLOCK) {
+        uint64_t bits = scan_block(s + i, &set);
+        if (bits != 0) {
+            return s + i + _u8_bitscan(bits);
+        }
+    }
+
+    SIMD_PROBE_TAIL(len - i);
+    for (; i < len; i++) {
+        if (s[i] == c) {
+            return s + i;
+        }
+    }
+    return NULL;
+}
+
+const char* simd_find_any_of(const char* s, int64_t len, const char* chars) {
+    SIMD_PROBE("simd_find_any_of", len);
+    if (strlen(chars) > SIMD_FIND_MAX) {
+        bool table[256] = {false};
+        for (const char* c = chars; *c != '\0'; c++) {
+            table[(uint8_t) *c] = true;
+        }
+        for (int64_t i = 0; i < len; i++) {
+            if (table[(uint8_t) s[i]]) {
+                return s + i;
+            }
+        }
+        return NULL;
+    }
+    if (chars[0] == '\0') {
+        return NULL;
+    }
+
+    scan_set set;
+    scan_set_init(&set, chars);
+    int64_t i = 0;
+    for (; i + SCAN_BLOCK <= len; i += SCAN_BLOCK) {
+        uint64_t bits = scan_block(s + i, &set);
+        if (bits != 0) {
+            return s + i + _u8_bitscan(bits);
+        }
+    }
+
+    SIMD_PROBE_TAIL(len - i);
+    uint64_t bits = scan_tail(s + i, len - i, chars);
+    return bits != 0 ? s + i + _u8_bitscan(bits) : NULL;
+}
+
+int64_t simd_split(const char* s, int64_t len, const char* delims, int64_t* positions, int64_t cap) {
+    SIMD_PROBE("simd_split", len);
+    if (delims[0] == '\0' || cap <= 0) {
+        return 0;
+    }
+
+    scan_set set;
+    scan_set_init(&set, delims);
+    int64_t n = 0;
+    for (int64_t i = 0; i < len; i += SCAN_BLOCK) {
+        uint64_t bits = i + SCAN_BLOCK <= len ? scan_block(s + i, &set) : scan_tail(s + i, len - i, delims);
+        while (bits != 0) {
+            positions[n++] = i + _u8_bitscan(bits);
+            if (n == cap) {
+                return n;
+            }
+            bits &= bits - 1;
+        }
+    }
+    return n;
+}
+
+/** ASCII Float Parsing **/
+
+static const double pow10_table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * Eight Digits At Once Within A 64-bit Word (Little Endian Only)
+ */
+static inline bool is_eight_digits(const char* p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return false;
+#else
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return ((v & 0xF0F0F0F0F0F0F0F0ull) | (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+#endif
+}
+
+static inline uint32_t parse_eight_digits(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    v -= 0x3030303030303030ull;
+    v = v * 10 + (v >> 8);
+    v = ((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) +
+         ((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+    return (uint32_t) v;
+}
+
+/**
+ * Accumulate A Run Of Digits Into mant; Returns The End Of The Run
+ */
+static const char* parse_digits(const char* p, const char* end, uint64_t* mant) {
+    while (end - p >= 8 && is_eight_digits(p)) {
+        *mant = *mant * 100000000ull + parse_eight_digits(p);
+        p += 8;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        *mant = *mant * 10 + (uint64_t) (*p - '0');
+        p++;
+    }
+    return p;
+}
+
+static float parse_slow(const char* p, const char* end) {
+    char local[PARSE_INLINE_FIELD];
+    int64_t n = end - p;
+    char* buf = n < PARSE_INLINE_FIELD ? local : malloc(n + 1);
+    if (buf == NULL) {
+        return NAN;
+    }
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+
+    char* stop;
+    float r = strtof(buf, &stop);
+    if (stop != buf + n) {
+        r = NAN;
+    }
+    if (buf != local) {
+        free(buf);
+    }
+    return r;
+}
+
+static float parse_field(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        end--;
+    }
+    if (p == end) {
+        return NAN;
+    }
+
+    const char* start = p;
+    bool neg = *p == '-';
+    if (*p == '-' || *p == '+') {
+        p++;
+    }
+
+    uint64_t mant = 0;
+    const char* q = parse_digits(p, end, &mant);
+    int64_t digits = q - p;
+    int64_t exp10 = 0;
+    p = q;
+    if (p < end && *p == '.') {
+        q = parse_digits(p + 1, end, &mant);
+        exp10 = -(q - p - 1);
+        digits += q - p - 1;
+        p = q;
+    }
+    if (digits == 0) {
+        return parse_slow(start, end);
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool eneg = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) {
+            p++;
+        }
+        int64_t e = 0;
+        const char* e0 = p;
+        while (p < end && *p >= '0' && *p <= '9' && e < 100000) {
+            e = e * 10 + (*p - '0');
+            p++;
+        }
+        if (p == e0) {
+            return parse_slow(start, end);
+        }
+        exp10 += eneg ? -e : e;
+    }
+    if (p != end || digits > 19 || mant > (1ull << 53) || exp10 < -22 || exp10 > 22) {
+        return parse_slow(start, end);
+    }
+
+    // mant and 10^|exp10| are exact doubles, so one operation rounds correctly.
+    double d = exp10 < 0 ? (double) mant / pow10_table[-exp10] : (double) mant * pow10_table[exp10];
+    // Narrowing can round twice when d sits exactly halfway between two floats,
+    // and below FLT_MIN the float spacing changes; leave both to strtof.
+    uint64_t bits;
+    memcpy(&bits, &d, 8);
+    if ((bits & 0x1FFFFFFFull) == 0x10000000ull || (d != 0. && d < FLT_MIN)) {
+        return parse_slow(start, end);
+    }
+    return neg ? -(float) d : (float) d;
+}
+
+int64_t float_parse_ascii(const char* s, int64_t len, const char* delims, float** out) {
+    SIMD_PROBE("float_parse_ascii", len);
+    scan_set set;
+    scan_set_init(&set, delims);
+    *out = NULL;
+
+    // First pass: count delimiters to size the output exactly.
+    int64_t fields = 0;
+    int64_t i = 0;
+    if (set.n > 0) {
+        for (; i + SCAN_BLOCK <= len; i += SCAN_BLOCK) {
+            fields += _u8_popcount(scan_block(s + i, &set));
+        }
+        fields += _u8_popcount(scan_tail(s + i, len - i, delims));
+    }
+    bool trailing = len > 0 && set.n > 0 && s[len - 1] != '\0' && strchr(delims, s[len - 1]) != NULL;
+    if (len > 0 && !trailing) {
+        fields++;
+    }
+
+    // The result feeds int length kernels, so it must fit an int.
+    int64_t padded = max((fields + FLOAT_VEC_SIZE - 1) / FLOAT_VEC_SIZE, 1) * FLOAT_VEC_SIZE;
+    if (padded > INT32_MAX) {
+        return -1;
+    }
+    float* values = float_malloc(padded);
+    if (values == NULL) {
+        return -1;
+    }
+
+    // Second pass: walk the delimiter bits and parse each field in place.
+    int64_t n = 0;
+    int64_t field = 0;
+    for (i = 0; i < len && set.n > 0; i += SCAN_BLOCK) {
+        uint64_t bits = i + SCAN_BLOCK <= len ? scan_block(s + i, &set) : scan_tail(s + i, len - i, delims);
+        while (bits != 0) {
+            int64_t pos = i + _u8_bitscan(bits);
+            values[n++] = parse_field(s + field, s + pos);
+            field = pos + 1;
+            bits &= bits - 1;
+        }
+    }
+    if (n < fields) {
+        values[n++] = parse_field(s + field, s + len);
+    }
+    for (int64_t k = n; k < padded; k++) {
+        values[k] = 0.f;
+    }
+
+    *out = values;
+    return n;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "generic_simd.h"
+
+/**
+ * Byte Scanning And Text Parsing
+ *
+ * Built on the _u8 ops: each block of 64 bytes is compared against broadcast
+ * characters, the per byte results are packed into one 64-bit mask with
+ * movemask, and matches are visited lowest first by bitscan. Lengths are in
+ * bytes; text does not need to be NUL terminated.
+ */
+
+/**
+ * Find The First Occurrence Of c
+ * @param s
+ * @param c
+ * @param len
+ * @return pointer to the match, or NULL
+ */
+const char* simd_memchr(const char* s, char c, int64_t len);
+
+/**
+ * Find The First Byte That Is Any Of The Characters In set
+ * @param s
+ * @param len
+ * @param set NUL terminated; sets longer than SIMD_FIND_MAX fall back to a lookup table
+ * @return pointer to the match, or NULL
+ */
+#define SIMD_FIND_MAX 16
+const char* simd_find_any_of(const char* s, int64_t len, const char* set);
+
+/**
+ * Record The Offset Of Every Delimiter, e.g. "\n" To Split Lines Or ",\n" For CSV Cells
+ * @param s
+ * @param len
+ * @param delims NUL terminated, at most SIMD_FIND_MAX characters
+ * @param positions receives offsets in ascending order
+ * @param cap capacity of positions
+ * @return offsets written; equal to cap when positions filled up, resume after positions[cap-1]
+ */
+int64_t simd_split(const char* s, int64_t len, const char* delims, int64_t* positions, int64_t cap);
+
+/**
+ * Parse Delimited ASCII Decimal Numbers Into A New float_malloc Buffer
+ *
+ * Fields are separated by any character of delims; a trailing delimiter does
+ * not start a new field. Spaces, tabs and carriage returns around a number are
+ * ignored, and empty or malformed fields become NaN. Up to 19 significant
+ * digits and small exponents take a fast path that is still correctly
+ * rounded; anything else, including inf and nan, goes through strtof.
+ * @param s
+ * @param len
+ * @param delims
+ * @param out receives the buffer, padded to a whole number of vectors; free with free()
+ * @return number of values, or -1 if the padded count exceeds INT32_MAX or the buffer could not be allocated
+ */
+int64_t float_parse_ascii(const char* s, int64_t len, const char* delims, float** out);
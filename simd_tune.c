@@ -0,0 +1,485 @@
+#include "simd_tune.h"
+#include "simd_quantize.h"
+#include "simd_reduce.h"
+#include "simd_stream.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
+
+/**
+ * Benchmark Sizes: Reductions And Elementwise Kernels Run In L1, Streaming
+ * Candidates Run Well Past The Last Level Cache
+ */
+#define TUNE_CACHED_LEN (4*1024)
+#define TUNE_STREAM_LEN (4*1024*1024)
+#define TUNE_STORE_MAX (8*1024*1024)
+#define TUNE_WORK (4*1024*1024)
+
+enum {
+    TUNING_UNSET,
+    TUNING_BUSY,
+    TUNING_READY
+};
+
+/**
+ * Every Tuning Is Published As A Fresh Copy Through An Atomic Pointer; Copies
+ * Are Never Freed, So A Pointer From simd_tuning_get Stays Valid And Whole.
+ * Until The First Publication Readers See The Defaults. simd_tune Benchmarks
+ * trial, Which Only The Tuning Thread Sees.
+ */
+static const simd_tuning tuning_default = SIMD_TUNING_DEFAULT;
+static _Atomic(const simd_tuning*) tuning = NULL;
+static simd_tuning trial;
+static atomic_int tuning_state = TUNING_UNSET;
+static _Thread_local bool tuning_thread;
+
+static const simd_tuning* tuning_current() {
+    const simd_tuning* t = atomic_load_explicit(&tuning, memory_order_acquire);
+    return t != NULL ? t : &tuning_default;
+}
+
+/**
+ * @return false, keeping the current tuning, if the copy could not be allocated
+ */
+static bool tuning_publish(const simd_tuning* t) {
+    simd_tuning* copy = malloc(sizeof(simd_tuning));
+    if (copy == NULL) {
+        return false;
+    }
+    *copy = *t;
+    atomic_store_explicit(&tuning, copy, memory_order_release);
+    return true;
+}
+
+/**
+ * Mark The Tuning Ready Unless First Use Loading Is Under Way, Which Finishes Itself
+ */
+static void tuning_ready() {
+    int expected = TUNING_UNSET;
+    atomic_compare_exchange_strong_explicit(&tuning_state, &expected, TUNING_READY, memory_order_acq_rel, memory_order_acquire);
+}
+
+static double seconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void tuning_sanitize(simd_tuning* t) {
+    simd_tuning d = SIMD_TUNING_DEFAULT;
+    int a = t->accumulators;
+    if (a != 1 && a != 2 && a != 4 && a != 8) {
+        t->accumulators = d.accumulators;
+    }
+    if (t->unroll != 1 && t->unroll != 2 && t->unroll != 4) {
+        t->unroll = d.unroll;
+    }
+    if (t->stream_threshold < 0) {
+        t->stream_threshold = d.stream_threshold;
+    }
+    if (t->stream_block < 4096) {
+        t->stream_block = d.stream_block;
+    }
+    if (t->prefetch_distance < 0) {
+        t->prefetch_distance = d.prefetch_distance;
+    }
+}
+
+static void tuning_init() {
+    int expected = TUNING_UNSET;
+    if (!atomic_compare_exchange_strong_explicit(&tuning_state, &expected, TUNING_BUSY, memory_order_acq_rel, memory_order_acquire)) {
+        return;
+    }
+    if (!simd_tuning_load(NULL)) {
+#ifndef SIMD_NO_AUTOTUNE
+        simd_tune(NULL);
+        simd_tuning_save(NULL);
+#endif
+    }
+    atomic_store_explicit(&tuning_state, TUNING_READY, memory_order_release);
+}
+
+const simd_tuning* simd_tuning_get() {
+    if (tuning_thread) {
+        return &trial;
+    }
+    if (atomic_load_explicit(&tuning_state, memory_order_acquire) == TUNING_UNSET) {
+        tuning_init();
+    }
+    return tuning_current();
+}
+
+void simd_tuning_set(const simd_tuning* t) {
+    simd_tuning s = *t;
+    tuning_sanitize(&s);
+    if (tuning_publish(&s)) {
+        tuning_ready();
+    }
+}
+
+bool simd_use_stream_store(int64_t bytes) {
+    return bytes >= simd_tuning_get()->stream_threshold;
+}
+
+void simd_cpu_signature(char* buf, int len) {
+    char vendor[13] = "generic";
+    unsigned signature = 0;
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int r[4];
+    __cpuid(r, 0);
+    memcpy(vendor, &r[1], 4);
+    memcpy(vendor + 4, &r[3], 4);
+    memcpy(vendor + 8, &r[2], 4);
+    vendor[12] = '\0';
+    __cpuid(r, 1);
+    signature = (unsigned) r[0];
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned a, b, c, d;
+    if (__get_cpuid(0, &a, &b, &c, &d)) {
+        memcpy(vendor, &b, 4);
+        memcpy(vendor + 4, &d, 4);
+        memcpy(vendor + 8, &c, 4);
+        vendor[12] = '\0';
+    }
+    if (__get_cpuid(1, &a, &b, &c, &d)) {
+        signature = a;
+    }
+#endif
+    snprintf(buf, len, "%s-%08x-%s", vendor, signature, SIMD_BACKEND);
+}
+
+/** Benchmarks **/
+
+static double* bench_doubles;
+static uint8_t* bench_bytes;
+static float* bench_floats;
+static float_stream_stage bench_stages[2];
+static int bench_nstages;
+static volatile double bench_sink;
+
+static void bench_scale_kernel(const float* in, float* out, int len, void* ctx) {
+    (void) ctx;
+    __float_vector S = _float_set1_vec(1.0001f);
+    int end = float_get_next_index(len, 0);
+
+    for (int i = 0; i < end; i += FLOAT_VEC_SIZE) {
+        _float_storeu(out + i, _float_mul_vec(_float_loadu(in + i), S));
+    }
+    for (int i = end; i < len; i++) {
+        out[i] = in[i] * 1.0001f;
+    }
+}
+
+static void bench_reduce(int len) {
+    bench_sink += double_sum(bench_doubles, len, ACCURACY_FAST);
+    bench_sink += double_dot(bench_doubles, bench_doubles + len, len, ACCURACY_FAST);
+}
+
+static void bench_reduce_canonical(int len) {
+    bench_sink += double_sum_canonical(bench_doubles, len);
+    bench_sink += double_dot_canonical(bench_doubles, bench_doubles + len, len);
+}
+
+static void bench_dequantize(int len) {
+    float_dequantize_u8(bench_bytes, bench_floats, len, 0.5f, 3);
+}
+
+static void bench_stream(int len) {
+    float_stream(bench_floats, bench_floats, len, bench_stages, bench_nstages);
+}
+
+/**
+ * Best Of Three Rounds, Each Calling fn Until At Least work Elements Were Processed
+ */
+static double bench(void (*fn)(int), int len, int64_t work) {
+    int64_t reps = max(work / len, 1);
+    double best = 1e300;
+    fn(len);
+    for (int round = 0; round < 3; round++) {
+        double t = seconds();
+        for (int64_t r = 0; r < reps; r++) {
+            fn(len);
+        }
+        best = min(best, seconds() - t);
+    }
+    return best;
+}
+
+static void tune_accumulators() {
+    static const int candidates[] = {1, 2, 4, 8};
+    double best_time = 1e300;
+    int best = trial.accumulators;
+    for (unsigned c = 0; c < sizeof(candidates)/sizeof(candidates[0]); c++) {
+        trial.accumulators = candidates[c];
+        double t = bench(bench_reduce, TUNE_CACHED_LEN, TUNE_WORK);
+        if (t < best_time) {
+            best_time = t;
+            best = candidates[c];
+        }
+    }
+    trial.accumulators = best;
+}
+
+static void tune_unroll() {
+    static const int candidates[] = {1, 2, 4};
+    double best_time = 1e300;
+    int best = trial.unroll;
+    trial.stream_threshold = INT64_MAX;
+    for (unsigned c = 0; c < sizeof(candidates)/sizeof(candidates[0]); c++) {
+        trial.unroll = candidates[c];
+        double t = bench(bench_dequantize, TUNE_CACHED_LEN, TUNE_WORK);
+        if (t < best_time) {
+            best_time = t;
+            best = candidates[c];
+        }
+    }
+    trial.unroll = best;
+}
+
+/**
+ * Streaming Must Win By 5% At A Size And Every Larger One To Set The Threshold
+ */
+static void tune_stream_threshold() {
+    static const int sizes[] = {64*1024, 256*1024, 1024*1024, 4*1024*1024, TUNE_STORE_MAX};
+    int64_t threshold = INT64_MAX;
+    for (int c = sizeof(sizes)/sizeof(sizes[0]) - 1; c >= 0; c--) {
+        int64_t work = max(sizes[c], TUNE_STORE_MAX);
+        trial.stream_threshold = 0;
+        double streamed = bench(bench_dequantize, sizes[c], work);
+        trial.stream_threshold = INT64_MAX;
+        double cached = bench(bench_dequantize, sizes[c], work);
+        if (streamed > 0.95 * cached) {
+            break;
+        }
+        threshold = (int64_t) sizes[c] * sizeof(float);
+    }
+    trial.stream_threshold = threshold;
+}
+
+static void tune_stream_block() {
+    static const int candidates[] = {32*1024, 64*1024, 128*1024, 256*1024, 512*1024, 1024*1024};
+    double best_time = 1e300;
+    int best = trial.stream_block;
+    bench_nstages = 2;
+    for (unsigned c = 0; c < sizeof(candidates)/sizeof(candidates[0]); c++) {
+        trial.stream_block = candidates[c];
+        double t = bench(bench_stream, TUNE_STREAM_LEN, TUNE_STREAM_LEN);
+        if (t < best_time) {
+            best_time = t;
+            best = candidates[c];
+        }
+    }
+    trial.stream_block = best;
+}
+
+static void tune_prefetch_distance() {
+    static const int candidates[] = {0, 256, 512, 1024, 2048, 4096, 8192};
+    double best_time = 1e300;
+    int best = trial.prefetch_distance;
+    bench_nstages = 1;
+    for (unsigned c = 0; c < sizeof(candidates)/sizeof(candidates[0]); c++) {
+        trial.prefetch_distance = candidates[c];
+        double t = bench(bench_stream, TUNE_STREAM_LEN, TUNE_STREAM_LEN);
+        if (t < best_time) {
+            best_time = t;
+            best = candidates[c];
+        }
+    }
+    trial.prefetch_distance = best;
+}
+
+void simd_tune(simd_tuning* t) {
+    simd_tuning d = SIMD_TUNING_DEFAULT;
+    trial = d;
+    tuning_thread = true;
+
+    bench_doubles = double_malloc(2*TUNE_CACHED_LEN);
+    bench_bytes = malloc(TUNE_STORE_MAX);
+    bench_floats = float_malloc(TUNE_STORE_MAX);
+    if (bench_doubles != NULL && bench_bytes != NULL && bench_floats != NULL) {
+        for (int i = 0; i < 2*TUNE_CACHED_LEN; i++) {
+            bench_doubles[i] = 1. / (i + 1);
+        }
+        for (int i = 0; i < TUNE_STORE_MAX; i++) {
+            bench_bytes[i] = (uint8_t) i;
+            bench_floats[i] = 1.f;
+        }
+        bench_stages[0].kernel = bench_scale_kernel;
+        bench_stages[1].kernel = bench_scale_kernel;
+
+        tune_accumulators();
+        tune_unroll();
+        tune_stream_threshold();
+        tune_stream_block();
+        tune_prefetch_distance();
+    } else {
+        trial = d;
+    }
+
+    free(bench_doubles);
+    free(bench_bytes);
+    free(bench_floats);
+    tuning_thread = false;
+    if (t != NULL) {
+        *t = trial;
+    }
+    if (tuning_publish(&trial)) {
+        tuning_ready();
+    }
+}
+
+double simd_deterministic_cost() {
+    simd_tuning_get();
+    bench_doubles = double_malloc(2*TUNE_CACHED_LEN);
+    if (bench_doubles == NULL) {
+        return 0.;
+    }
+    for (int i = 0; i < 2*TUNE_CACHED_LEN; i++) {
+        bench_doubles[i] = 1. / (i + 1);
+    }
+    double fast = bench(bench_reduce, TUNE_CACHED_LEN, TUNE_WORK);
+    double canonical = bench(bench_reduce_canonical, TUNE_CACHED_LEN, TUNE_WORK);
+    free(bench_doubles);
+    bench_doubles = NULL;
+    return canonical / fast;
+}
+
+/** Profile Files **/
+
+#define PROFILE_LINE 512
+#define PROFILE_FORMAT "%127s accumulators=%d unroll=%d stream_threshold=%lld stream_block=%d prefetch_distance=%d"
+
+static bool profile_path(const char* path, char* buf, int len) {
+    if (path != NULL) {
+        snprintf(buf, len, "%s", path);
+        return true;
+    }
+    const char* env = getenv("SIMD_TUNE_PROFILE");
+    if (env != NULL) {
+        snprintf(buf, len, "%s", env);
+        return env[0] != '\0';
+    }
+    const char* home = getenv("HOME");
+    if (home == NULL) {
+        home = getenv("USERPROFILE");
+    }
+    if (home == NULL) {
+        return false;
+    }
+    snprintf(buf, len, "%s/.generic_simd_tune", home);
+    return true;
+}
+
+static bool profile_parse(const char* line, char* key, simd_tuning* t) {
+    long long threshold;
+    if (sscanf(line, PROFILE_FORMAT, key, &t->accumulators, &t->unroll, &threshold,
+               &t->stream_block, &t->prefetch_distance) != 6) {
+        return false;
+    }
+    t->stream_threshold = threshold;
+    return true;
+}
+
+static void profile_write(FILE* f, const char* key, const simd_tuning* t) {
+    fprintf(f, "%s accumulators=%d unroll=%d stream_threshold=%lld stream_block=%d prefetch_distance=%d\n",
+            key, t->accumulators, t->unroll, (long long) t->stream_threshold, t->stream_block, t->prefetch_distance);
+}
+
+bool simd_tuning_load(const char* path) {
+    char file[1024];
+    char sig[128];
+    char line[PROFILE_LINE];
+    char key[128];
+    simd_tuning t;
+    bool found = false;
+
+    if (!profile_path(path, file, sizeof(file))) {
+        return false;
+    }
+    FILE* f = fopen(file, "r");
+    if (f == NULL) {
+        return false;
+    }
+    simd_cpu_signature(sig, sizeof(sig));
+    while (!found && fgets(line, sizeof(line), f) != NULL) {
+        found = profile_parse(line, key, &t) && strcmp(key, sig) == 0;
+    }
+    fclose(f);
+
+    if (found) {
+        simd_tuning_set(&t);
+    }
+    return found;
+}
+
+bool simd_tuning_save(const char* path) {
+    char file[1024];
+    char tmp[1040];
+    char sig[128];
+    char line[PROFILE_LINE];
+    char key[128];
+    simd_tuning t;
+
+    if (!profile_path(path, file, sizeof(file))) {
+        return false;
+    }
+    snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+    FILE* out = fopen(tmp, "w");
+    if (out == NULL) {
+        return false;
+    }
+
+    // Copy every other host's entry, then write ours; rename makes the update atomic.
+    simd_cpu_signature(sig, sizeof(sig));
+    FILE* in = fopen(file, "r");
+    if (in != NULL) {
+        while (fgets(line, sizeof(line), in) != NULL) {
+            if (!profile_parse(line, key, &t) || strcmp(key, sig) != 0) {
+                fputs(line, out);
+            }
+        }
+        fclose(in);
+    } else {
+        fprintf(out, "# generic_simd tuning profile, one line per cpuid signature\n");
+    }
+
+    profile_write(out, sig, tuning_current());
+    if (fclose(out) != 0) {
+        remove(tmp);
+        return false;
+    }
+#ifdef _WIN32
+    remove(file);
+#endif
+    if (rename(tmp, file) != 0) {
+        remove(tmp);
+        return false;
+    }
+    return true;
+}
+
+#ifdef SIMD_TUNE_MAIN
+/**
+ * Command Line Tuner: simd_tune [profile]
+ */
+int main(int argc, char** argv) {
+    const char* path = argc > 1 ? argv[1] : NULL;
+    char sig[128];
+    simd_tuning t;
+
+    simd_cpu_signature(sig, sizeof(sig));
+    simd_tune(&t);
+    profile_write(stdout, sig, &t);
+    printf("deterministic reductions: %.2fx\n", simd_deterministic_cost());
+    if (!simd_tuning_save(path)) {
+        fprintf(stderr, "simd_tune: could not write the tuning profile\n");
+        return 1;
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+#include "generic_simd.h"
+#include <stdio.h>
+
+/**
+ * Kernel Autotuning
+ *
+ * The best unroll factor, accumulator count, streaming store threshold and
+ * block sizes depend on the host, not on the instruction set compiled for.
+ * On first use the active tuning is loaded from a profile file keyed by the
+ * cpuid signature; if the host has no entry yet, each candidate is benchmarked
+ * (well under a second) and the winner is appended to the profile so later
+ * runs start tuned. One profile file can serve a whole fleet of machines.
+ *
+ * The profile lives at $SIMD_TUNE_PROFILE, or $HOME/.generic_simd_tune when
+ * unset; an empty SIMD_TUNE_PROFILE disables persistence. Building with
+ * -DSIMD_NO_AUTOTUNE skips first use benchmarking: hosts without a profile
+ * entry run on the defaults below. Build simd_tune.c with -DSIMD_TUNE_MAIN
+ * for a command line tool that tunes and writes the profile ahead of time.
+ */
+typedef struct {
+    int accumulators;           // Independent vector accumulators in reductions: 1, 2, 4 or 8.
+    int unroll;                 // Vectors per iteration in elementwise kernels: 1, 2 or 4.
+    int64_t stream_threshold;   // Outputs of at least this many bytes use non-temporal stores.
+    int stream_block;           // float_stream block size in bytes.
+    int prefetch_distance;      // float_stream prefetch distance in bytes, 0 disables.
+} simd_tuning;
+
+#define SIMD_TUNING_DEFAULT {4, 1, 8*1024*1024, 128*1024, 512}
+
+/**
+ * Active Tuning; Loads Or Benchmarks On First Call
+ *
+ * While another thread loads or benchmarks, this returns the tuning published
+ * before, or the defaults. The returned tuning is never modified or freed;
+ * call again to see a newer one.
+ * @return
+ */
+const simd_tuning* simd_tuning_get();
+
+/**
+ * Replace The Active Tuning
+ * @param t
+ */
+void simd_tuning_set(const simd_tuning* t);
+
+/**
+ * Benchmark Every Candidate On This Host And Make The Result Active
+ * @param t receives the result, may be NULL
+ */
+void simd_tune(simd_tuning* t);
+
+/**
+ * Time Of The Canonical Order Reductions Relative To The Tuned Fast Ones
+ *
+ * Compares double_sum and double_dot at ACCURACY_FAST with their canonical
+ * counterparts on an L1 resident array: the slowdown a SIMD_DETERMINISTIC
+ * build pays in its reductions. Within such a build both sides are canonical
+ * and the ratio is about 1.
+ * @return e.g. 1.3 for 30% slower; 0 if the buffer could not be allocated
+ */
+double simd_deterministic_cost();
+
+/**
+ * Load Or Store This Host's Entry In A Profile File; Entries Of Other Hosts Are Kept
+ * @param path NULL for the default location
+ * @return false if the file or entry is missing or cannot be written
+ */
+bool simd_tuning_load(const char* path);
+bool simd_tuning_save(const char* path);
+
+/**
+ * Profile Key: cpuid Vendor And Signature Plus SIMD_BACKEND, e.g. GenuineIntel-000906ea-avx2
+ * @param buf
+ * @param len
+ */
+void simd_cpu_signature(char* buf, int len);
+
+/**
+ * Whether An Output Of bytes Bytes Should Bypass The Cache
+ * @param bytes
+ * @return
+ */
+bool simd_use_stream_store(int64_t bytes);
@@ -0,0 +1,303 @@
+#include "simd_view.h"
+#include "simd_instrument.h"
+#include "simd_reduce.h"
+
+/**
+ * Strided Rows Are Staged Through A Stack Buffer Of This Many Elements
+ */
+#define VIEW_BLOCK 1024
+#define VIEW_TILE 16
+
+/**
+ * Normalized Iteration Space Shared By Up To Two Views Of The Same Shape
+ *
+ * Unit dimensions are dropped, dimensions are ordered so the smallest stride
+ * of the first view is innermost, and dimensions that are contiguous with
+ * their inner neighbour in both views are merged into one longer row.
+ */
+typedef struct {
+    int ndim;
+    int shape[FLOAT_VIEW_MAX_DIMS];
+    int64_t strides[2][FLOAT_VIEW_MAX_DIMS];
+} view_layout;
+
+static int64_t abs64(int64_t x) {
+    return x < 0 ? -x : x;
+}
+
+static void layout_init(view_layout* l, const float_view* a, const float_view* b) {
+    int n = 0;
+    for (int d = 0; d < a->ndim; d++) {
+        if (a->shape[d] != 1) {
+            l->shape[n] = a->shape[d];
+            l->strides[0][n] = a->strides[d];
+            l->strides[1][n] = b != NULL ? b->strides[d] : 0;
+            n++;
+        }
+    }
+    if (n == 0) {
+        l->shape[0] = 1;
+        l->strides[0][0] = 1;
+        l->strides[1][0] = 1;
+        n = 1;
+    }
+
+    // Stable insertion sort by descending stride of the first view.
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && abs64(l->strides[0][j-1]) < abs64(l->strides[0][j]); j--) {
+            int s = l->shape[j];
+            l->shape[j] = l->shape[j-1];
+            l->shape[j-1] = s;
+            for (int v = 0; v < 2; v++) {
+                int64_t t = l->strides[v][j];
+                l->strides[v][j] = l->strides[v][j-1];
+                l->strides[v][j-1] = t;
+            }
+        }
+    }
+
+    // Merge dimension d into d+1 when it simply continues the row.
+    for (int d = n - 2; d >= 0; d--) {
+        bool merge = (int64_t) l->shape[d] * l->shape[d+1] <= INT32_MAX;
+        for (int v = 0; v < 2; v++) {
+            merge = merge && l->strides[v][d] == l->shape[d+1] * l->strides[v][d+1];
+        }
+        if (merge) {
+            l->shape[d+1] *= l->shape[d];
+            for (int k = d; k < n - 1; k++) {
+                l->shape[k] = l->shape[k+1];
+                l->strides[0][k] = l->strides[0][k+1];
+                l->strides[1][k] = l->strides[1][k+1];
+            }
+            n--;
+        }
+    }
+    l->ndim = n;
+}
+
+/**
+ * Advance The Odometer Over The First dims Dimensions, Tracking Both Offsets
+ * @return false once every position has been visited
+ */
+static bool layout_next(const view_layout* l, int dims, int* idx, int64_t* off) {
+    for (int d = dims - 1; d >= 0; d--) {
+        idx[d]++;
+        off[0] += l->strides[0][d];
+        off[1] += l->strides[1][d];
+        if (idx[d] < l->shape[d]) {
+            return true;
+        }
+        off[0] -= l->strides[0][d] * l->shape[d];
+        off[1] -= l->strides[1][d] * l->shape[d];
+        idx[d] = 0;
+    }
+    return false;
+}
+
+/**
+ * Gather Offsets For One Vector Of A Strided Row, Or false If They Overflow int32
+ */
+static bool stride_indices(int64_t stride, __int32_vector* idx) {
+    if (abs64(stride) * FLOAT_VEC_SIZE > INT32_MAX) {
+        return false;
+    }
+    int32_t lanes[FLOAT_VEC_SIZE];
+    for (int j = 0; j < FLOAT_VEC_SIZE; j++) {
+        lanes[j] = (int32_t) (j * stride);
+    }
+    *idx = _int32_loadu(lanes);
+    return true;
+}
+
+static void float_gather_strided(const float* src, int64_t stride, float* dst, int len) {
+    __int32_vector idx;
+    int i = 0;
+    if (stride_indices(stride, &idx)) {
+        for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+            _float_storeu(dst + i, _float_gather_vec(src + i * stride, idx));
+        }
+    }
+    for (; i < len; i++) {
+        dst[i] = src[i * stride];
+    }
+}
+
+static void float_scatter_strided(const float* src, float* dst, int64_t stride, int len) {
+    for (int i = 0; i < len; i++) {
+        dst[i * stride] = src[i];
+    }
+}
+
+static float float_row_sum(const float* src, int64_t stride, int len) {
+#ifdef SIMD_DETERMINISTIC
+    if (stride == 1) {
+        return float_sum_canonical(src, len);
+    }
+    float lanes[SIMD_CANON_LANES] = {0};
+    for (int i = 0; i < len; i++) {
+        lanes[i % SIMD_CANON_LANES] += src[i * stride];
+    }
+    return _float_canon_fold(lanes);
+#else
+    __float_vector S0 = _float_setzero_vec();
+    __float_vector S1 = _float_setzero_vec();
+    __int32_vector idx;
+    int i = 0;
+
+    if (stride == 1) {
+        for (; i + 2*FLOAT_VEC_SIZE <= len; i += 2*FLOAT_VEC_SIZE) {
+            S0 = _float_add_vec(S0, _float_loadu(src + i));
+            S1 = _float_add_vec(S1, _float_loadu(src + i + FLOAT_VEC_SIZE));
+        }
+    } else if (stride_indices(stride, &idx)) {
+        // Gather straight into the accumulators; nothing is staged.
+        for (; i + FLOAT_VEC_SIZE <= len; i += FLOAT_VEC_SIZE) {
+            S0 = _float_add_vec(S0, _float_gather_vec(src + i * stride, idx));
+        }
+    }
+
+    float s = _float_hsum_vec(_float_add_vec(S0, S1));
+    for (; i < len; i++) {
+        s += src[i * stride];
+    }
+    return s;
+#endif
+}
+
+float_view float_view_1d(float* base, int len, int64_t stride) {
+    float_view v = {base, 1, {len}, {stride}};
+    return v;
+}
+
+float_view float_view_2d(float* base, int rows, int cols, int64_t row_stride, int64_t col_stride) {
+    float_view v = {base, 2, {rows, cols}, {row_stride, col_stride}};
+    return v;
+}
+
+int64_t float_view_size(const float_view* v) {
+    int64_t n = 1;
+    for (int d = 0; d < v->ndim; d++) {
+        n *= v->shape[d];
+    }
+    return n;
+}
+
+void float_view_apply(const float_view* in, const float_view* out, float_stream_kernel kernel, void* ctx) {
+    SIMD_PROBE("float_view_apply", float_view_size(in));
+    if (float_view_size(in) == 0) {
+        return;
+    }
+
+    view_layout l;
+    layout_init(&l, in, out);
+    int inner = l.ndim - 1;
+    int len = l.shape[inner];
+    int64_t si = l.strides[0][inner];
+    int64_t so = l.strides[1][inner];
+    int idx[FLOAT_VIEW_MAX_DIMS] = {0};
+    int64_t off[2] = {0, 0};
+    float buf[VIEW_BLOCK];
+
+    do {
+        const float* src = in->base + off[0];
+        float* dst = out->base + off[1];
+
+        if (si == 1 && so == 1) {
+            kernel(src, dst, len, ctx);
+            continue;
+        }
+
+        for (int i = 0; i < len; i += VIEW_BLOCK) {
+            int n = min(VIEW_BLOCK, len - i);
+            const float* x = src + i * si;
+            float* y = dst + i * so;
+            if (si != 1) {
+                float_gather_strided(x, si, buf, n);
+                x = buf;
+            }
+            kernel(x, so == 1 ? y : buf, n, ctx);
+            if (so != 1) {
+                float_scatter_strided(buf, y, so, n);
+            }
+        }
+    } while (layout_next(&l, inner, idx, off));
+}
+
+float float_view_sum(const float_view* v) {
+    SIMD_PROBE("float_view_sum", float_view_size(v));
+    if (float_view_size(v) == 0) {
+        return 0.f;
+    }
+
+    view_layout l;
+    layout_init(&l, v, NULL);
+    int inner = l.ndim - 1;
+    int idx[FLOAT_VIEW_MAX_DIMS] = {0};
+    int64_t off[2] = {0, 0};
+    float s = 0.f;
+
+    do {
+        s += float_row_sum(v->base + off[0], l.strides[0][inner], l.shape[inner]);
+    } while (layout_next(&l, inner, idx, off));
+    return s;
+}
+
+/**
+ * Copy The Innermost Two Dimensions, rows x cols
+ *
+ * When the source runs along rows but the destination along columns, a
+ * straight loop would stride through memory on one side for every element;
+ * VIEW_TILE square tiles keep both sides within a handful of cache lines.
+ */
+static void float_copy_2d(const float* src, float* dst, int rows, int cols, int64_t srs, int64_t scs, int64_t drs, int64_t dcs) {
+    if (scs == 1 && dcs == 1) {
+        for (int r = 0; r < rows; r++) {
+            memcpy(dst + r * drs, src + r * srs, cols * sizeof(float));
+        }
+    } else if (dcs == 1 && abs64(srs) < abs64(scs)) {
+        for (int r0 = 0; r0 < rows; r0 += VIEW_TILE) {
+            for (int c0 = 0; c0 < cols; c0 += VIEW_TILE) {
+                int rn = min(r0 + VIEW_TILE, rows);
+                int cn = min(c0 + VIEW_TILE, cols);
+                for (int r = r0; r < rn; r++) {
+                    for (int c = c0; c < cn; c++) {
+                        dst[r * drs + c] = src[r * srs + c * scs];
+                    }
+                }
+            }
+        }
+    } else {
+        for (int r = 0; r < rows; r++) {
+            if (dcs == 1) {
+                float_gather_strided(src + r * srs, scs, dst + r * drs, cols);
+            } else {
+                for (int c = 0; c < cols; c++) {
+                    dst[r * drs + c * dcs] = src[r * srs + c * scs];
+                }
+            }
+        }
+    }
+}
+
+void float_view_copy(const float_view* src, const float_view* dst) {
+    SIMD_PROBE("float_view_copy", float_view_size(src));
+    if (float_view_size(src) == 0) {
+        return;
+    }
+
+    // Order the loops by the destination so writes stay sequential.
+    view_layout l;
+    layout_init(&l, dst, src);
+    int inner = l.ndim - 1;
+    int outer = l.ndim >= 2 ? l.ndim - 2 : 0;
+    int rows = l.ndim >= 2 ? l.shape[outer] : 1;
+    int64_t drs = l.ndim >= 2 ? l.strides[0][outer] : 0;
+    int64_t srs = l.ndim >= 2 ? l.strides[1][outer] : 0;
+    int idx[FLOAT_VIEW_MAX_DIMS] = {0};
+    int64_t off[2] = {0, 0};
+
+    do {
+        float_copy_2d(src->base + off[1], dst->base + off[0], rows, l.shape[inner],
+                      srs, l.strides[1][inner], drs, l.strides[0][inner]);
+    } while (layout_next(&l, outer, idx, off));
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "generic_simd.h"
+#include "simd_stream.h"
+
+/**
+ * Strided Views
+ *
+ * A view describes an n-dimensional array inside existing memory: element
+ * (i0, i1, ...) lives at base[i0*strides[0] + i1*strides[1] + ...]. Strides are
+ * in elements and may be negative. Matrix columns, image channels and
+ * transposes are all views, so kernels can run on them without staging copies.
+ *
+ * Rows whose innermost stride is 1 run on the contiguous kernels directly;
+ * other rows are gathered a few vectors at a time into an L1 resident block.
+ */
+#define FLOAT_VIEW_MAX_DIMS 4
+
+typedef struct {
+    float* base;
+    int ndim;
+    int shape[FLOAT_VIEW_MAX_DIMS];
+    int64_t strides[FLOAT_VIEW_MAX_DIMS];
+} float_view;
+
+/**
+ * Build 1-D And 2-D Views
+ * @param base
+ * @param len / rows, cols
+ * @param stride / row_stride, col_stride
+ * @return
+ */
+float_view float_view_1d(float* base, int len, int64_t stride);
+float_view float_view_2d(float* base, int rows, int cols, int64_t row_stride, int64_t col_stride);
+
+/**
+ * Number Of Elements In A View
+ * @param v
+ * @return
+ */
+int64_t float_view_size(const float_view* v);
+
+/**
+ * Apply An Elementwise Kernel From in To out; Both Views Must Have The Same Shape
+ * @param in
+ * @param out may alias in
+ * @param kernel
+ * @param ctx
+ */
+void float_view_apply(const float_view* in, const float_view* out, float_stream_kernel kernel, void* ctx);
+
+/**
+ * Sum Of All Elements
+ * @param v
+ * @return
+ */
+float float_view_sum(const float_view* v);
+
+/**
+ * Copy src Into dst, Same Shape; Mismatched Layouts Are Copied In Cache Blocked Tiles
+ * @param src
+ * @param dst
+ */
+void float_view_copy(const float_view* src, const float_view* dst);